@@ -1,8 +1,20 @@
 #include <iostream>
 #include <vector>
 #include <mpi.h>
+#include <omp.h>
 #include <algorithm>
-#include <set>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <tuple>
+#include <string>
+#include <memory>
+#include "partition.h"
+#include "mpi_exchange.h"
+#include "termination.h"
+#include "rma_visited.h"
+#include "ghost_table.h"
+#include "dfs_engine.h"
 using namespace std;
 
 struct DomainInfo {
@@ -11,25 +23,19 @@ struct DomainInfo {
     int startVertex;
     int endVertex;
     int localSize;
+    vector<int> rankStart;  // rank r owns [rankStart[r], rankStart[r + 1])
 };
 
-DomainInfo setupDomain(int totalVertices, int rank, int numRanks) {
+// Vertices are relabeled so that every rank owns a contiguous range;
+// partStart comes from relabelByPart.
+DomainInfo setupDomain(const vector<int>& partStart, int rank, int numRanks) {
     DomainInfo domain;
     domain.rank = rank;
     domain.numRanks = numRanks;
-    
-    int baseSize = totalVertices / numRanks;
-    int remainder = totalVertices % numRanks;
-    
-    if (rank < remainder) {
-        domain.localSize = baseSize + 1;
-        domain.startVertex = rank * domain.localSize;
-    } else {
-        domain.localSize = baseSize;
-        domain.startVertex = remainder * (baseSize + 1) + (rank - remainder) * baseSize;
-    }
-    
-    domain.endVertex = domain.startVertex + domain.localSize;
+    domain.rankStart = partStart;
+    domain.startVertex = partStart[rank];
+    domain.endVertex = partStart[rank + 1];
+    domain.localSize = domain.endVertex - domain.startVertex;
     
     return domain;
 }
@@ -38,51 +44,163 @@ bool isLocalVertex(int vertex, const DomainInfo& domain) {
     return vertex >= domain.startVertex && vertex < domain.endVertex;
 }
 
-int findOwnerRank(int vertex, int totalVertices, int numRanks) {
-    int baseSize = totalVertices / numRanks;
-    int remainder = totalVertices % numRanks;
-    
-    int threshold = remainder * (baseSize + 1);
-    if (vertex < threshold) {
-        return vertex / (baseSize + 1);
-    } else {
-        return remainder + (vertex - threshold) / baseSize;
-    }
+int findOwnerRank(int vertex, const DomainInfo& domain) {
+    return upper_bound(domain.rankStart.begin(), domain.rankStart.end(), vertex) 
+           - domain.rankStart.begin() - 1;
 }
 
-bool localDFS(const vector<vector<int>>& adj, vector<bool>& visited, 
-              int vertex, vector<int>& localResult, 
-              set<int>& boundaryVertices, const DomainInfo& domain,
-              int target, bool& found) {
+// One bit per global vertex; set from any thread with an atomic fetch-or.
+struct VertexBitmap {
+    vector<uint64_t> words;
     
-    if (visited[vertex]) return false;
-    
-    visited[vertex] = true;
-    localResult.push_back(vertex);
+    void resize(int numVertices) {
+        words.assign((numVertices + 63) / 64, 0);
+    }
     
-    if (vertex == target) {
-        found = true;
-        return true;
+    // True only for the caller that flipped the bit from 0 to 1.
+    bool testAndSet(int vertex) {
+        uint64_t bit = 1ULL << (vertex & 63);
+        uint64_t old;
+        #pragma omp atomic capture
+        { old = words[vertex >> 6]; words[vertex >> 6] |= bit; }
+        return (old & bit) == 0;
     }
     
-    double work = 0;
-    for (int i = 0; i < 1000; i++) {
-        work += (vertex * i) % 100;
+    void clear(int vertex) {
+        words[vertex >> 6] &= ~(1ULL << (vertex & 63));
     }
+};
+
+// Scratch state kept across calls to dfs_mpi_with_overlap. Buffers are
+// cleared rather than freed, so repeated traversals stop allocating once
+// they reach their high-water mark.
+struct MPITraversalScratch {
+    vector<char> visited;
+    VertexBitmap boundarySeen;       // remote vertices recorded in this call
+    vector<int> asyncBoundary;       // async engine: bits it set in boundarySeen
+    vector<vector<int>> threadResults;
+    vector<vector<int>> threadStacks;
+    vector<vector<int>> sendBuffers;
+    vector<int> received;            // flat, as returned by BoundaryExchange
+    vector<vector<int>> visitNotices; // async engine: visited vertices to report, per rank
+    vector<int> interiorVertices;
+    vector<int> localBoundaryVertices;
+    vector<int> phase2Roots;
     
-    for (int neighbor : adj[vertex]) {
-        if (isLocalVertex(neighbor, domain)) {
-            if (!visited[neighbor]) {
-                if (localDFS(adj, visited, neighbor, localResult, boundaryVertices, domain, target, found)) {
-                    return true;
-                }
-            }
+    void prepare(const DomainInfo& domain, int totalVertices, int numThreads) {
+        if (visited.size() != paddedFlagCount(totalVertices)) {
+            visited.assign(paddedFlagCount(totalVertices), 0);
+            boundarySeen.resize(totalVertices);
         } else {
-            boundaryVertices.insert(neighbor);
+            fill(visited.begin() + domain.startVertex, visited.begin() + domain.endVertex, 0);
+            // Only bits recorded by the previous call can be set.
+            for (const vector<int>& bucket : sendBuffers) {
+                for (int v : bucket) boundarySeen.clear(v);
+            }
+            for (int v : asyncBoundary) boundarySeen.clear(v);
         }
+        
+        asyncBoundary.clear();
+        threadResults.resize(numThreads);
+        threadStacks.resize(numThreads);
+        for (int t = 0; t < numThreads; t++) {
+            threadResults[t].clear();
+            threadStacks[t].clear();
+        }
+        
+        sendBuffers.resize(domain.numRanks);
+        visitNotices.resize(domain.numRanks);
+        for (int r = 0; r < domain.numRanks; r++) {
+            sendBuffers[r].clear();
+            visitNotices[r].clear();
+        }
+        received.clear();
+        interiorVertices.clear();
+        localBoundaryVertices.clear();
+        phase2Roots.clear();
     }
-    
-    return false;
+};
+
+const int STOP_POLL_INTERVAL = 64;   // vertices between stop-signal polls
+
+// Search status shared by the threads of one rank during a traversal.
+struct SearchState {
+    bool targetFound = false;       // this rank found the target
+    bool stop = false;              // some rank found it; stop traversing
+    StopSignal* signal = nullptr;   // null disables cross-rank early stop
+};
+
+bool shouldStop(const SearchState& search) {
+    bool found, stop;
+    #pragma omp atomic read
+    found = search.targetFound;
+    #pragma omp atomic read
+    stop = search.stop;
+    return found || stop;
+}
+
+// Publishes a local find to all ranks and picks up finds from other ranks.
+// Calls MPI, so only the master thread may use it.
+void pollStopSignal(SearchState& search) {
+    if (!search.signal) return;
+    
+    bool found;
+    #pragma omp atomic read
+    found = search.targetFound;
+    if (found) search.signal->raise();
+    
+    if (search.signal->raised()) {
+        #pragma omp atomic write
+        search.stop = true;
+    }
+}
+
+// Engine hooks for one thread's share of a rank's traversal: stops on the
+// target or a stop signal and does not follow remote neighbors. Those were
+// all sent to their owners before the traversal started.
+struct LocalSearchVisitor : DfsVisitor {
+    vector<int>& localResult;
+    const DomainInfo& domain;
+    int target;
+    SearchState& search;
+    bool isMaster = omp_get_thread_num() == 0;
+    
+    LocalSearchVisitor(vector<int>& localResult, const DomainInfo& domain, int target, SearchState& search)
+        : localResult(localResult), domain(domain), target(target), search(search) {}
+    
+    bool stopRequested() const { return shouldStop(search); }
+    
+    bool follow(int neighbor) { return isLocalVertex(neighbor, domain); }
+    
+    bool discover(int v) {
+        localResult.push_back(v);
+        
+        if (v == target) {
+            #pragma omp atomic write
+            search.targetFound = true;
+            if (isMaster) pollStopSignal(search);
+            return false;
+        }
+        
+        if (isMaster && localResult.size() % STOP_POLL_INTERVAL == 0) {
+            pollStopSignal(search);
+        }
+        
+        simulatedWork(v);
+        return true;
+    }
+};
+
+// The shared engine run from one root. Vertices are claimed when popped,
+// which keeps the recursive visit order for a single thread and lets
+// concurrent threads share `visited`. Returns true if the search stopped.
+bool localDFS(const vector<vector<int>>& adj, vector<char>& visited, 
+              int vertex, vector<int>& localResult, vector<int>& stack,
+              const DomainInfo& domain, int target, SearchState& search) {
+    
+    AtomicVisited claims(visited.data());
+    LocalSearchVisitor visitor(localResult, domain, target, search);
+    return dfsFromRoot(adj, vertex, claims, stack, visitor);
 }
 
 bool isBoundaryVertex(int vertex, const vector<vector<int>>& adj, const DomainInfo& domain) {
@@ -96,131 +214,452 @@ bool isBoundaryVertex(int vertex, const vector<vector<int>>& adj, const DomainIn
     return false;
 }
 
+// Ranks owning remote neighbors of our boundary vertices, i.e. everyone we
+// may send boundary data to.
+vector<int> communicationPartners(const vector<vector<int>>& adj, const DomainInfo& domain) {
+    vector<char> isPartner(domain.numRanks, 0);
+    for (int v = domain.startVertex; v < domain.endVertex; v++) {
+        for (int neighbor : adj[v]) {
+            if (!isLocalVertex(neighbor, domain)) {
+                isPartner[findOwnerRank(neighbor, domain)] = 1;
+            }
+        }
+    }
+    
+    vector<int> partners;
+    for (int r = 0; r < domain.numRanks; r++) {
+        if (isPartner[r]) partners.push_back(r);
+    }
+    return partners;
+}
+
+// Hybrid MPI+OpenMP traversal: each rank runs numThreads threads over its own
+// partition. With MPI_THREAD_FUNNELED only the master thread calls MPI; with
+// MPI_THREAD_MULTIPLE and point-to-point exchange the data receives are
+// spread over all threads. Boundary vertices go out through `exchange`.
 pair<vector<int>, bool> dfs_mpi_with_overlap(const vector<vector<int>>& adj, 
                                               const DomainInfo& domain, 
-                                              int target) {
+                                              int target, int threadLevel,
+                                              int numThreads,
+                                              BoundaryExchange& exchange,
+                                              MPITraversalScratch& scratch,
+                                              StopSignal* stopSignal) {
     int totalVertices = adj.size();
-    vector<bool> visited(totalVertices, false);
-    vector<int> localResult;
-    set<int> boundaryVertices;
-    bool targetFound = false;
+    SearchState search;
+    search.signal = stopSignal;
+    if (stopSignal) stopSignal->reset();
     
-    vector<int> interiorVertices;
-    vector<int> localBoundaryVertices;
+    if (threadLevel < MPI_THREAD_FUNNELED) {
+        numThreads = 1;
+    }
+    scratch.prepare(domain, totalVertices, numThreads);
+    vector<char>& visited = scratch.visited;
     
     for (int v = domain.startVertex; v < domain.endVertex; v++) {
         if (isBoundaryVertex(v, adj, domain)) {
-            localBoundaryVertices.push_back(v);
+            scratch.localBoundaryVertices.push_back(v);
         } else {
-            interiorVertices.push_back(v);
-        }
-    }
-    
-    vector<MPI_Request> recvRequests;
-    vector<vector<int>> recvBuffers(domain.numRanks);
-    vector<int> recvSizes(domain.numRanks, 0);
-    
-    for (int srcRank = 0; srcRank < domain.numRanks; srcRank++) {
-        if (srcRank != domain.rank) {
-            MPI_Request req;
-            MPI_Irecv(&recvSizes[srcRank], 1, MPI_INT, srcRank, 0, 
-                     MPI_COMM_WORLD, &req);
-            recvRequests.push_back(req);
+            scratch.interiorVertices.push_back(v);
         }
     }
     
-    set<int> externalVerticesSet;
-    for (int v : localBoundaryVertices) {
+    // Remote neighbors of boundary vertices go straight into per-owner
+    // buffers; the bitmap drops duplicates and sorting restores the
+    // ascending order the receiver used to get.
+    for (int v : scratch.localBoundaryVertices) {
         for (int neighbor : adj[v]) {
-            if (!isLocalVertex(neighbor, domain)) {
-                externalVerticesSet.insert(neighbor);
+            if (!isLocalVertex(neighbor, domain) && scratch.boundarySeen.testAndSet(neighbor)) {
+                scratch.sendBuffers[findOwnerRank(neighbor, domain)].push_back(neighbor);
             }
         }
     }
     
-    vector<MPI_Request> sendRequests;
-    vector<vector<int>> sendBuffers(domain.numRanks);
-    
-    for (int extV : externalVerticesSet) {
-        int ownerRank = findOwnerRank(extV, totalVertices, domain.numRanks);
-        if (ownerRank != domain.rank) {
-            sendBuffers[ownerRank].push_back(extV);
-        }
+    for (vector<int>& buffer : scratch.sendBuffers) {
+        sort(buffer.begin(), buffer.end());
     }
-    
-    for (int destRank = 0; destRank < domain.numRanks; destRank++) {
-        if (destRank != domain.rank) {
-            int size = sendBuffers[destRank].size();
-            
-            MPI_Request sizeReq;
-            MPI_Isend(&size, 1, MPI_INT, destRank, 0, MPI_COMM_WORLD, &sizeReq);
-            sendRequests.push_back(sizeReq);
+    exchange.start(scratch.sendBuffers);
+    
+    const vector<int>& interiorVertices = scratch.interiorVertices;
+    vector<int>& phase2Roots = scratch.phase2Roots;
+    
+    #pragma omp parallel num_threads(numThreads)
+    {
+        int tid = omp_get_thread_num();
+        bool countsArrived = false;
+        
+        // Interior vertices need no remote data, so they overlap the count exchange.
+        #pragma omp for schedule(dynamic, 64) nowait
+        for (size_t k = 0; k < interiorVertices.size(); k++) {
+            int v = interiorVertices[k];
+            if (!visited[v] && !shouldStop(search)) {
+                localDFS(adj, visited, v, scratch.threadResults[tid], scratch.threadStacks[tid],
+                         domain, target, search);
+            }
             
-            if (size > 0) {
-                MPI_Request dataReq;
-                MPI_Isend(sendBuffers[destRank].data(), size, MPI_INT, 
-                         destRank, 1, MPI_COMM_WORLD, &dataReq);
-                sendRequests.push_back(dataReq);
+            if (tid == 0) {
+                if (!countsArrived) countsArrived = exchange.countsArrived();
+                pollStopSignal(search);
             }
         }
-    }
-    
-    for (int v : interiorVertices) {
-        if (!visited[v] && !targetFound) {
-            set<int> dummy;
-            if (localDFS(adj, visited, v, localResult, dummy, domain, target, targetFound)) {
-                break;
+        
+        #pragma omp master
+        {
+            exchange.waitCounts(scratch.received);
+        }
+        #pragma omp barrier
+        
+        if (threadLevel == MPI_THREAD_MULTIPLE && exchange.perSourceReceive()) {
+            #pragma omp for schedule(dynamic, 1)
+            for (int k = 0; k < exchange.numSources(); k++) {
+                exchange.receiveFrom(k, scratch.received);
+            }
+        } else {
+            #pragma omp master
+            {
+                exchange.receiveAll(scratch.received);
+            }
+            #pragma omp barrier
+        }
+        
+        #pragma omp single
+        {
+            phase2Roots = scratch.localBoundaryVertices;
+            for (int v : scratch.received) {
+                if (isLocalVertex(v, domain)) {
+                    phase2Roots.push_back(v);
+                }
             }
         }
+        
+        #pragma omp for schedule(dynamic, 16)
+        for (size_t k = 0; k < phase2Roots.size(); k++) {
+            int v = phase2Roots[k];
+            if (!visited[v] && !shouldStop(search)) {
+                localDFS(adj, visited, v, scratch.threadResults[tid], scratch.threadStacks[tid],
+                         domain, target, search);
+            }
+            if (tid == 0) pollStopSignal(search);
+        }
     }
     
-    if (!recvRequests.empty()) {
-        MPI_Waitall(recvRequests.size(), recvRequests.data(), MPI_STATUSES_IGNORE);
+    // A thread other than the master may have found the target after the
+    // master's last poll; raise the signal for it.
+    pollStopSignal(search);
+    
+    size_t resultSize = 0;
+    for (int t = 0; t < numThreads; t++) {
+        resultSize += scratch.threadResults[t].size();
     }
+    vector<int> localResult;
+    localResult.reserve(resultSize);
+    for (int t = 0; t < numThreads; t++) {
+        localResult.insert(localResult.end(), scratch.threadResults[t].begin(), scratch.threadResults[t].end());
+    }
+    
+    exchange.finish();
     
-    recvRequests.clear();
-    for (int srcRank = 0; srcRank < domain.numRanks; srcRank++) {
-        if (srcRank != domain.rank && recvSizes[srcRank] > 0) {
-            recvBuffers[srcRank].resize(recvSizes[srcRank]);
-            MPI_Request req;
-            MPI_Irecv(recvBuffers[srcRank].data(), recvSizes[srcRank], MPI_INT, 
-                     srcRank, 1, MPI_COMM_WORLD, &req);
-            recvRequests.push_back(req);
+    return {localResult, search.targetFound};
+}
+
+const int WORK_TAG = 2;
+
+// Outgoing work batches for the asynchronous engine. A message is
+// [work count, work vertices..., visit notices...]: the notices piggyback
+// ghost-state updates on work that is being sent anyway. Each Isend owns its
+// buffer until the request completes; finished buffers are recycled.
+struct AsyncSendQueue {
+    vector<MPI_Request> requests;
+    vector<vector<int>> inFlight;
+    vector<vector<int>> spare;
+    
+    void send(vector<int>& batch, vector<int>& notices, int destRank, MPI_Comm comm) {
+        vector<int> buffer;
+        if (!spare.empty()) {
+            buffer = move(spare.back());
+            spare.pop_back();
         }
+        buffer.push_back(batch.size());
+        buffer.insert(buffer.end(), batch.begin(), batch.end());
+        buffer.insert(buffer.end(), notices.begin(), notices.end());
+        batch.clear();
+        notices.clear();
+        
+        MPI_Request req;
+        MPI_Isend(buffer.data(), buffer.size(), MPI_INT, destRank, WORK_TAG, comm, &req);
+        requests.push_back(req);
+        inFlight.push_back(move(buffer));
     }
     
-    if (!recvRequests.empty()) {
-        MPI_Waitall(recvRequests.size(), recvRequests.data(), MPI_STATUSES_IGNORE);
+    void progress() {
+        for (size_t k = 0; k < requests.size();) {
+            int done = 0;
+            MPI_Test(&requests[k], &done, MPI_STATUS_IGNORE);
+            if (done) {
+                spare.push_back(move(inFlight[k]));
+                spare.back().clear();
+                requests[k] = requests.back();
+                requests.pop_back();
+                inFlight[k] = move(inFlight.back());
+                inFlight.pop_back();
+            } else {
+                k++;
+            }
+        }
     }
     
-    for (int v : localBoundaryVertices) {
-        if (!visited[v] && !targetFound) {
-            localDFS(adj, visited, v, localResult, boundaryVertices, domain, target, targetFound);
+    void waitAll() {
+        if (!requests.empty()) {
+            MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
         }
+        requests.clear();
+        inFlight.clear();
     }
+};
+
+struct AsyncStats {
+    long long messagesSent = 0;
+    long long terminationWaves = 0;
+    long long rmaClaims = 0;
+    long long rmaClaimsWon = 0;
+    long long ghostHits = 0;        // remote sends skipped because the owner reported a visit
+    long long noticesSent = 0;
+};
+
+// Visited flags of the asynchronous engine: 0 free, 1 taken, 2 claimed for
+// this rank by another rank and not expanded yet. With rma set, a free
+// local vertex is claimed in the window when popped, and a pre-claimed one
+// is taken without a second claim. Flags other than 0 read as visited, so
+// neither taken nor pre-claimed vertices are pushed again.
+struct AsyncVisited {
+    vector<char>& flags;
+    RmaVisitedWindow* rma;
+    int startVertex;
     
-    for (int srcRank = 0; srcRank < domain.numRanks; srcRank++) {
-        if (srcRank != domain.rank && !targetFound) {
-            for (int v : recvBuffers[srcRank]) {
-                if (isLocalVertex(v, domain) && !visited[v]) {
-                    set<int> dummy;
-                    if (localDFS(adj, visited, v, localResult, dummy, domain, target, targetFound)) {
-                        break;
-                    }
+    bool isVisited(int v) const { return flags[v]; }
+    VisitedView view() const { return VisitedView::bytes(flags.data()); }
+    void prefetch(int v) const { __builtin_prefetch(&flags[v]); }
+    bool markVisited(int v) {
+        char old = flags[v];
+        flags[v] = 1;
+        if (old == 2) return true;
+        if (old) return false;
+        return !rma || rma->claimLocal(v - startVertex);
+    }
+};
+
+// Asynchronous traversal: each rank walks its own partition and forwards a
+// remote neighbor to its owner in batches as soon as it meets it, instead of
+// in one bulk-synchronous exchange. Incoming batches are polled every
+// pollInterval vertices and pushed onto the local stack. A TerminationDetector
+// decides when all ranks are idle with no batches in flight; after a
+// stop-signal a rank only drains incoming batches until then.
+//
+// The local part is the shared engine loop: a visitor follows local
+// neighbors, forwards remote ones, and polls between pops.
+//
+// With rmaVisited set, vertices are claimed in the owner's visited bitmap
+// with a one-sided atomic: local ones when popped, unless no other rank can
+// reach them, and remote ones before they are forwarded. Only
+// vertices this rank won are sent, and the owner expands them without
+// checking.
+//
+// With ghosts set, every remote neighbor is looked up in the ghost table
+// first. Ghosts already forwarded or reported visited by their owner are
+// skipped, and visits of local vertices other ranks hold as ghosts are
+// piggybacked on the next batch to those ranks.
+pair<vector<int>, bool> dfs_mpi_async(const vector<vector<int>>& adj, 
+                                       const DomainInfo& domain, 
+                                       int target, MPITraversalScratch& scratch,
+                                       AsyncStats& stats, StopSignal* stopSignal,
+                                       RmaVisitedWindow* rmaVisited = nullptr,
+                                       GhostTable* ghosts = nullptr,
+                                       int batchSize = 256, int pollInterval = 64) {
+    int totalVertices = adj.size();
+    bool targetFound = false;
+    bool stopping = false;   // target found here or on another rank
+    if (stopSignal) stopSignal->reset();
+    if (rmaVisited) rmaVisited->reset();
+    if (ghosts) ghosts->reset();
+    stats.ghostHits = 0;
+    stats.noticesSent = 0;
+    
+    scratch.prepare(domain, totalVertices, 1);
+    vector<char>& visited = scratch.visited;
+    vector<int>& localResult = scratch.threadResults[0];
+    vector<int>& stack = scratch.threadStacks[0];
+    vector<vector<int>>& outgoing = scratch.sendBuffers;
+    vector<vector<int>>& notices = scratch.visitNotices;
+    vector<int>& incoming = scratch.received;
+    
+    TerminationDetector detector(MPI_COMM_WORLD);
+    AsyncSendQueue sendQueue;
+    AsyncVisited claims{visited, rmaVisited, domain.startVertex};
+    int nextRoot = domain.startVertex;
+    int sinceLastPoll = 0;
+    
+    auto pollIncoming = [&]() {
+        int flag = 1;
+        while (flag) {
+            MPI_Status status;
+            MPI_Iprobe(MPI_ANY_SOURCE, WORK_TAG, MPI_COMM_WORLD, &flag, &status);
+            if (!flag) break;
+            
+            int count;
+            MPI_Get_count(&status, MPI_INT, &count);
+            incoming.resize(count);
+            MPI_Recv(incoming.data(), count, MPI_INT, status.MPI_SOURCE, WORK_TAG, 
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            detector.messageReceived();
+            
+            int workCount = incoming[0];
+            if (ghosts) {
+                for (int k = 1 + workCount; k < count; k++) {
+                    int g = ghosts->find(incoming[k]);
+                    if (g >= 0) ghosts->setState(g, GhostTable::VISITED);
                 }
             }
+            
+            if (stopping) continue;
+            for (int k = 1; k <= workCount; k++) {
+                int v = incoming[k];
+                if (rmaVisited) {
+                    visited[v] = 2;
+                    stack.push_back(v);
+                } else if (!visited[v]) {
+                    stack.push_back(v);
+                }
+            }
+        }
+    };
+    
+    auto flushAll = [&]() {
+        for (int r = 0; r < domain.numRanks; r++) {
+            if (!outgoing[r].empty()) {
+                stats.noticesSent += notices[r].size();
+                sendQueue.send(outgoing[r], notices[r], r, MPI_COMM_WORLD);
+                detector.messageSent();
+            }
+        }
+    };
+    
+    // Engine hooks. visit returns false to stop the traversal, poll whether
+    // it has stopped.
+    auto visit = [&](int v) {
+        localResult.push_back(v);
+        
+        if (ghosts) {
+            for (const int* r = ghosts->watchersBegin(v); r != ghosts->watchersEnd(v); ++r) {
+                notices[*r].push_back(v);
+            }
+        }
+        
+        if (v == target) {
+            targetFound = true;
+            stopping = true;
+            if (stopSignal) stopSignal->raise();
+            return false;
+        }
+        
+        simulatedWork(v);
+        return true;
+    };
+    
+    auto forward = [&](int neighbor) {
+        if (ghosts) {
+            int g = ghosts->find(neighbor);
+            if (ghosts->state(g) != GhostTable::UNKNOWN) {
+                if (ghosts->state(g) == GhostTable::VISITED) stats.ghostHits++;
+                return;
+            }
+            ghosts->setState(g, GhostTable::SENT);
+        } else if (scratch.boundarySeen.testAndSet(neighbor)) {
+            scratch.asyncBoundary.push_back(neighbor);
+        } else {
+            return;
+        }
+        
+        int owner = findOwnerRank(neighbor, domain);
+        if (rmaVisited && !rmaVisited->claim(owner, neighbor - domain.rankStart[owner])) {
+            return;
+        }
+        outgoing[owner].push_back(neighbor);
+        if ((int)outgoing[owner].size() >= batchSize) {
+            stats.noticesSent += notices[owner].size();
+            sendQueue.send(outgoing[owner], notices[owner], owner, MPI_COMM_WORLD);
+            detector.messageSent();
+        }
+    };
+    
+    auto poll = [&]() {
+        if (++sinceLastPoll >= pollInterval) {
+            sinceLastPoll = 0;
+            pollIncoming();
+            sendQueue.progress();
+            detector.poll(false);
+            if (stopSignal && stopSignal->raised()) stopping = true;
+        }
+        return stopping;
+    };
+    
+    struct AsyncVisitor : DfsVisitor {
+        decltype(visit)& onVisit;
+        decltype(forward)& onRemote;
+        decltype(poll)& onPoll;
+        const DomainInfo& domain;
+        
+        bool stopRequested() { return onPoll(); }
+        bool discover(int v) { return onVisit(v); }
+        bool follow(int neighbor) {
+            if (isLocalVertex(neighbor, domain)) return true;
+            onRemote(neighbor);
+            return false;
+        }
+    };
+    AsyncVisitor visitor{{}, visit, forward, poll, domain};
+    
+    while (true) {
+        if (!stack.empty() && !stopping) {
+            if (dfsDrain(adj, claims, stack, visitor)) stack.clear();
+            continue;
+        }
+        
+        if (!stopping && stopSignal && stopSignal->raised()) {
+            stopping = true;
+            stack.clear();
         }
+        
+        if (!stopping && nextRoot < domain.endVertex) {
+            if (!visited[nextRoot]) stack.push_back(nextRoot);
+            nextRoot++;
+            continue;
+        }
+        
+        // Out of local work: push partial batches, then look for more.
+        flushAll();
+        sendQueue.progress();
+        pollIncoming();
+        if (!stack.empty() && !stopping) continue;
+        
+        if (detector.poll(true)) break;
     }
     
-    if (!sendRequests.empty()) {
-        MPI_Waitall(sendRequests.size(), sendRequests.data(), MPI_STATUSES_IGNORE);
+    sendQueue.waitAll();
+    stats.messagesSent = detector.messagesSent();
+    stats.terminationWaves = detector.wavesCompleted();
+    if (rmaVisited) {
+        stats.rmaClaims = rmaVisited->attempted();
+        stats.rmaClaimsWon = rmaVisited->won();
     }
     
     return {localResult, targetFound};
 }
 
 int main(int argc, char** argv) {
-    MPI_Init(&argc, &argv);
+    // Ask for full thread support; FUNNELED is enough because the master
+    // thread does all communication when MULTIPLE is not available.
+    int threadLevel;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &threadLevel);
+    int numThreads = threadLevel >= MPI_THREAD_FUNNELED ? omp_get_max_threads() : 1;
     
     int rank, numRanks;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -228,6 +667,43 @@ int main(int argc, char** argv) {
     
     int numVertices = 50000;
     int targetVertex = 42000;
+    enum class PartitionMode { LabelPropagation, VertexBlock, EdgeBlock };
+    PartitionMode partitionMode = PartitionMode::LabelPropagation;
+    int numRuns = 1;
+    bool useAsyncEngine = false;
+    bool earlyStop = true;
+    bool useRmaClaims = false;
+    bool useGhostCache = true;
+    vector<ExchangeMode> exchangeModes = {ExchangeMode::Alltoallv};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--partition=block") == 0) {
+            partitionMode = PartitionMode::VertexBlock;
+        } else if (strcmp(argv[i], "--partition=edges") == 0) {
+            partitionMode = PartitionMode::EdgeBlock;
+        } else if (strncmp(argv[i], "--runs=", 7) == 0) {
+            numRuns = max(1, atoi(argv[i] + 7));
+        } else if (strcmp(argv[i], "--ghost-cache=off") == 0) {
+            useGhostCache = false;
+        } else if (strcmp(argv[i], "--early-stop=off") == 0) {
+            earlyStop = false;
+        } else if (strcmp(argv[i], "--engine=async") == 0) {
+            useAsyncEngine = true;
+        } else if (strcmp(argv[i], "--engine=async-rma") == 0) {
+            useAsyncEngine = true;
+            useRmaClaims = true;
+        } else if (strcmp(argv[i], "--exchange=all") == 0) {
+            exchangeModes = {ExchangeMode::PointToPoint, ExchangeMode::Alltoallv, 
+                             ExchangeMode::NeighborAlltoallv};
+        } else if (strncmp(argv[i], "--exchange=", 11) == 0) {
+            ExchangeMode mode;
+            if (parseExchangeMode(argv[i] + 11, mode)) {
+                exchangeModes = {mode};
+            } else if (rank == 0) {
+                cerr << "unknown exchange mode " << (argv[i] + 11) 
+                     << ", expected p2p, alltoallv, neighbor or all" << endl;
+            }
+        }
+    }
     
     MPI_Bcast(&numVertices, 1, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Bcast(&targetVertex, 1, MPI_INT, 0, MPI_COMM_WORLD);
@@ -238,7 +714,10 @@ int main(int argc, char** argv) {
         cout << "running distributed DFS..." << endl;
         cout << "graph size: " << numVertices << " vertices" << endl;
         cout << "searching for vertex: " << targetVertex << endl;
-        cout << "using " << numRanks << " processes" << endl << endl;
+        cout << "using " << numRanks << " processes x " << numThreads << " threads";
+        cout << " (MPI thread level: " << (threadLevel == MPI_THREAD_MULTIPLE ? "multiple" :
+                 threadLevel == MPI_THREAD_SERIALIZED ? "serialized" :
+                 threadLevel == MPI_THREAD_FUNNELED ? "funneled" : "single") << ")" << endl << endl;
     }
     
     for (int i = 0; i < numVertices; i++) {
@@ -248,50 +727,173 @@ int main(int argc, char** argv) {
         }
     }
     
-    DomainInfo domain = setupDomain(numVertices, rank, numRanks);
+    // Rank 0 partitions the graph and broadcasts the owner table; every rank
+    // then applies the same relabeling so owned vertices are contiguous.
+    double partitionStart = MPI_Wtime();
+    vector<int> owner(numVertices);
+    if (rank == 0) {
+        if (partitionMode == PartitionMode::LabelPropagation) {
+            owner = labelPropagationPartition(adj, numRanks);
+        } else if (partitionMode == PartitionMode::EdgeBlock) {
+            owner = blockPartitionByEdges(adj, numRanks);
+        } else {
+            owner = blockPartitionByVertices(numVertices, numRanks);
+        }
+    }
+    MPI_Bcast(owner.data(), numVertices, MPI_INT, 0, MPI_COMM_WORLD);
+    
+    Relabeling relabel = relabelByPart(owner, numRanks);
+    long long cutEdges = countCutEdges(adj, owner);
+    long long totalEdges = 0;
+    for (const vector<int>& neighbors : adj) {
+        totalEdges += neighbors.size();
+    }
+    adj = applyRelabeling(adj, relabel);
+    targetVertex = relabel.newId[targetVertex];
+    double partitionTime = MPI_Wtime() - partitionStart;
+    
+    DomainInfo domain = setupDomain(relabel.partStart, rank, numRanks);
     
     if (rank == 0) {
-        cout << "domain decomposition (1D block):" << endl;
+        cout << "domain decomposition (" << (partitionMode == PartitionMode::LabelPropagation ? "label propagation" :
+                                             partitionMode == PartitionMode::EdgeBlock ? "1D block by edges" : "1D block")
+             << "):" << endl;
+        cout << "cut edges: " << cutEdges << " of " << totalEdges << " ("
+             << (100.0 * cutEdges / max(totalEdges, 1LL)) << "%), partitioning took "
+             << (partitionTime * 1000.0) << " ms" << endl;
     }
     for (int r = 0; r < numRanks; r++) {
         if (rank == r) {
-            cout << "rank " << rank << " owns vertices " << domain.startVertex 
-                 << " to " << (domain.endVertex-1) << endl;
+            long long localEdges = 0;
+            for (int v = domain.startVertex; v < domain.endVertex; v++) {
+                localEdges += adj[v].size();
+            }
+            cout << "rank " << rank << " owns " << domain.localSize << " vertices, " 
+                 << localEdges << " edges" << endl;
         }
         MPI_Barrier(MPI_COMM_WORLD);
     }
     
-    MPI_Barrier(MPI_COMM_WORLD);
-    double startTime = MPI_Wtime();
-    
-    auto [localResult, localFound] = dfs_mpi_with_overlap(adj, domain, targetVertex);
-    
-    MPI_Barrier(MPI_COMM_WORLD);
-    double endTime = MPI_Wtime();
-    
-    int localCount = localResult.size();
-    int totalCount = 0;
-    MPI_Reduce(&localCount, &totalCount, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
-    
-    int foundFlag = localFound ? 1 : 0;
-    int globalFound = 0;
-    MPI_Reduce(&foundFlag, &globalFound, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
-    
-    double localTime = endTime - startTime;
-    double maxTime = 0;
-    MPI_Reduce(&localTime, &maxTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    vector<int> partners = communicationPartners(adj, domain);
+    unique_ptr<StopSignal> stopSignal;
+    if (earlyStop) {
+        stopSignal.reset(new StopSignal(MPI_COMM_WORLD));
+    }
     
-    if (rank == 0) {
-        cout << endl;
-        cout << "time taken: " << (maxTime * 1000.0) << " ms" << endl;
-        cout << "vertices visited: " << totalCount << endl;
-        if (globalFound) {
-            cout << "found target: vertex " << targetVertex << endl;
-        } else {
-            cout << "target not found: vertex " << targetVertex << endl;
+    // Runs one engine numRuns times and prints rank 0's summary. Repeated runs
+    // reuse the same scratch buffers, as a query service would.
+    auto timeEngine = [&](const string& label, auto runOnce) {
+        MPITraversalScratch scratch;
+        vector<int> localResult;
+        bool localFound = false;
+        double startTime = 0, endTime = 0;
+        double warmTime = 0;
+        
+        for (int run = 0; run < numRuns; run++) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            double runStart = MPI_Wtime();
+            
+            tie(localResult, localFound) = runOnce(scratch);
+            
+            MPI_Barrier(MPI_COMM_WORLD);
+            double runEnd = MPI_Wtime();
+            if (run == 0) {
+                startTime = runStart;
+                endTime = runEnd;
+            } else {
+                warmTime += runEnd - runStart;
+            }
+        }
+        
+        int localCount = localResult.size();
+        int totalCount = 0;
+        MPI_Reduce(&localCount, &totalCount, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+        
+        int foundFlag = localFound ? 1 : 0;
+        int globalFound = 0;
+        MPI_Reduce(&foundFlag, &globalFound, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
+        
+        double localTime = endTime - startTime;
+        double maxTime = 0;
+        MPI_Reduce(&localTime, &maxTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        double maxWarmTime = 0;
+        MPI_Reduce(&warmTime, &maxWarmTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        
+        if (rank == 0) {
+            cout << endl;
+            cout << label << endl;
+            cout << "time taken: " << (maxTime * 1000.0) << " ms" << endl;
+            if (numRuns > 1) {
+                cout << "average of " << (numRuns - 1) << " warm runs: " 
+                     << (maxWarmTime / (numRuns - 1) * 1000.0) << " ms" << endl;
+            }
+            cout << "vertices visited: " << totalCount << endl;
+            if (globalFound) {
+                cout << "found target: vertex " << relabel.oldId[targetVertex] << endl;
+            } else {
+                cout << "target not found: vertex " << relabel.oldId[targetVertex] << endl;
+            }
+        }
+    };
+    
+    if (useAsyncEngine) {
+        AsyncStats stats;
+        unique_ptr<RmaVisitedWindow> rmaVisited;
+        if (useRmaClaims) {
+            // Only local vertices with an edge from another rank can be claimed remotely
+            vector<char> remoteReachable(domain.localSize, 0);
+            for (int u = 0; u < (int)adj.size(); u++) {
+                if (isLocalVertex(u, domain)) continue;
+                for (int v : adj[u]) {
+                    if (isLocalVertex(v, domain)) remoteReachable[v - domain.startVertex] = 1;
+                }
+            }
+            rmaVisited.reset(new RmaVisitedWindow(MPI_COMM_WORLD, domain.localSize, move(remoteReachable)));
+        }
+        GhostTable ghostTable;
+        if (useGhostCache) {
+            ghostTable.build(adj, domain.rankStart, rank);
+        }
+        
+        timeEngine(useRmaClaims ? "engine: async, one-sided visited claims" : "engine: async",
+                   [&](MPITraversalScratch& scratch) {
+            return dfs_mpi_async(adj, domain, targetVertex, scratch, stats, stopSignal.get(),
+                                 rmaVisited.get(), useGhostCache ? &ghostTable : nullptr);
+        });
+        
+        long long totals[5] = {0, 0, 0, 0, 0};
+        long long local[5] = {stats.messagesSent, stats.rmaClaims, stats.rmaClaimsWon,
+                              stats.ghostHits, stats.noticesSent};
+        MPI_Reduce(local, totals, 5, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (rank == 0) {
+            cout << "last run: " << totals[0] << " work messages, " 
+                 << stats.terminationWaves << " termination waves" << endl;
+            if (useRmaClaims) {
+                cout << "one-sided claims of remote vertices: " << totals[1] << " attempted, " << totals[2] << " won" << endl;
+            }
+            if (useGhostCache) {
+                cout << "ghost cache: " << totals[3] << " sends suppressed, " 
+                     << totals[4] << " visit notices piggybacked" << endl;
+            }
+        }
+    } else {
+        for (ExchangeMode mode : exchangeModes) {
+            BoundaryExchange exchange(MPI_COMM_WORLD, mode, partners);
+            
+            int maxPartners = 0;
+            int localPartners = exchange.numDestinations();
+            MPI_Allreduce(&localPartners, &maxPartners, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+            
+            string label = string("exchange: ") + exchangeModeName(mode) + " (max " 
+                           + to_string(maxPartners) + " destination ranks per rank)";
+            timeEngine(label, [&](MPITraversalScratch& scratch) {
+                return dfs_mpi_with_overlap(adj, domain, targetVertex, threadLevel,
+                                            numThreads, exchange, scratch, stopSignal.get());
+            });
         }
     }
     
+    stopSignal.reset();   // frees its window, which must happen before MPI_Finalize
     MPI_Finalize();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <sched.h>
+
+// Thread pinning helpers shared by the NUMA placement code and the
+// work-stealing engine.
+
+// Pins the calling thread to one CPU; returns false if the kernel refused.
+inline bool pinThreadToCpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// Restores the calling thread's affinity when it goes out of scope, so that
+// pinning inside one parallel region does not leak into later ones.
+class AffinityGuard {
+public:
+    AffinityGuard() { sched_getaffinity(0, sizeof(saved), &saved); }
+    ~AffinityGuard() { sched_setaffinity(0, sizeof(saved), &saved); }
+
+private:
+    cpu_set_t saved;
+};
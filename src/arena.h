@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <sys/mman.h>
+#include "csr_graph.h"
+
+// Bump allocator for graph arrays and traversal scratch.
+//
+// Memory comes from the OS in large chunks and is handed out by advancing a
+// pointer; individual frees are no-ops and everything is released when the
+// arena is reset or destroyed. Chunks can be backed by huge pages to cut TLB
+// misses: Transparent maps 2 MiB-aligned chunks and marks them with
+// madvise(MADV_HUGEPAGE), Explicit asks for MAP_HUGETLB pages and falls back
+// to Transparent when none are reserved. backing() says what was obtained.
+
+enum class HugePages { None, Transparent, Explicit };
+
+inline const char *hugePagesName(HugePages mode) {
+    switch (mode)
+    {
+    case HugePages::None: return "4K pages";
+    case HugePages::Transparent: return "transparent huge pages";
+    case HugePages::Explicit: return "explicit huge pages";
+    }
+    return "unknown";
+}
+
+class Arena {
+public:
+    static const size_t HUGE_PAGE = 2 << 20;
+
+    explicit Arena(HugePages mode = HugePages::Transparent, size_t chunkBytes = 64 << 20)
+        : mode(mode), chunkBytes(chunkBytes), obtained(mode) {}
+
+    ~Arena() { release(); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        uintptr_t p = (cursor + align - 1) & ~(uintptr_t)(align - 1);
+        if (p + bytes > limit)
+        {
+            newChunk(bytes + align);
+            p = (cursor + align - 1) & ~(uintptr_t)(align - 1);
+        }
+        cursor = p + bytes;
+        lastAllocation = p;
+        numAllocations++;
+        bytesAllocated += bytes;
+        return (void *)p;
+    }
+
+    // Frees only the most recent allocation; anything else waits for reset().
+    void deallocate(void *p, size_t bytes) {
+        if ((uintptr_t)p == lastAllocation && (uintptr_t)p + bytes == cursor)
+            cursor = lastAllocation;
+    }
+
+    // Returns every chunk to the OS; previously returned pointers dangle.
+    void reset() { release(); }
+
+    HugePages backing() const { return obtained; }
+    long long allocations() const { return numAllocations; }     // served by the arena
+    long long systemAllocations() const { return chunks.size(); } // mmap calls behind them
+    size_t bytesUsed() const { return bytesAllocated; }
+    size_t bytesMapped() const {
+        size_t total = 0;
+        for (const Chunk &chunk : chunks)
+            total += chunk.bytes;
+        return total;
+    }
+
+private:
+    struct Chunk {
+        void *base;
+        size_t bytes;
+    };
+
+    void newChunk(size_t minBytes) {
+        size_t bytes = std::max(chunkBytes, minBytes);
+        void *base = MAP_FAILED;
+
+        if (mode != HugePages::None)
+            bytes = (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+
+#ifdef MAP_HUGETLB
+        if (mode == HugePages::Explicit)
+        {
+            base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (base == MAP_FAILED)
+                obtained = HugePages::Transparent;
+        }
+#endif
+        if (base == MAP_FAILED && mode != HugePages::None)
+            base = mapAligned(bytes);
+        if (base == MAP_FAILED)
+        {
+            base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            obtained = HugePages::None;
+        }
+        if (base == MAP_FAILED)
+            throw std::bad_alloc();
+
+        chunks.push_back({base, bytes});
+        cursor = (uintptr_t)base;
+        limit = cursor + bytes;
+    }
+
+    // 2 MiB-aligned mapping marked for transparent huge pages.
+    void *mapAligned(size_t bytes) {
+        size_t padded = bytes + HUGE_PAGE;
+        void *raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return MAP_FAILED;
+
+        uintptr_t start = ((uintptr_t)raw + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1);
+        if (start > (uintptr_t)raw)
+            munmap(raw, start - (uintptr_t)raw);
+        uintptr_t end = (uintptr_t)raw + padded;
+        if (end > start + bytes)
+            munmap((void *)(start + bytes), end - (start + bytes));
+
+#ifdef MADV_HUGEPAGE
+        if (madvise((void *)start, bytes, MADV_HUGEPAGE) != 0)
+            obtained = HugePages::None;
+#else
+        obtained = HugePages::None;
+#endif
+        return (void *)start;
+    }
+
+    void release() {
+        for (const Chunk &chunk : chunks)
+            munmap(chunk.base, chunk.bytes);
+        chunks.clear();
+        cursor = limit = lastAllocation = 0;
+    }
+
+    HugePages mode;
+    size_t chunkBytes;
+    HugePages obtained;
+    std::vector<Chunk> chunks;
+    uintptr_t cursor = 0;
+    uintptr_t limit = 0;
+    uintptr_t lastAllocation = 0;
+    long long numAllocations = 0;
+    size_t bytesAllocated = 0;
+};
+
+// Standard allocator interface over an Arena, for std::vector and friends.
+// A default-constructed allocator uses a process-wide arena.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator() : arena(&defaultArena()) {}
+    explicit ArenaAllocator(Arena &arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t count) { return (T *)arena->allocate(count * sizeof(T), alignof(T)); }
+    void deallocate(T *p, size_t count) { arena->deallocate(p, count * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+
+    static Arena &defaultArena() {
+        static Arena arena;
+        return arena;
+    }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+    Arena *arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+typedef BasicCSRGraph<ArenaAllocator> ArenaCSRGraph;
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Compressed adjacency in a stream-vbyte layout.
+//
+// Each neighbor list is sorted and stored as deltas (the first entry as a
+// delta from 0). Deltas go in groups of four: one control byte holding four
+// 2-bit lengths (1-4 bytes each), followed by the data bytes. A group decodes
+// with one SSSE3 shuffle plus a prefix sum, selected at runtime with a scalar
+// fallback; a trailing partial group is always decoded scalar.
+//
+// Sorting means traversals see neighbors in ascending ID order, which is the
+// same order as on an adjacency list with sorted lists.
+
+namespace svb {
+
+// Bytes needed for one delta, as its 2-bit code (length - 1).
+inline int lengthCode(uint32_t value) {
+    return value < (1u << 8) ? 0 : value < (1u << 16) ? 1 : value < (1u << 24) ? 2 : 3;
+}
+
+struct Tables {
+    uint8_t shuffle[256][16]; // control byte -> pshufb mask
+    uint8_t length[256];      // control byte -> data bytes in the group
+
+    Tables() {
+        for (int c = 0; c < 256; c++)
+        {
+            int pos = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                int len = ((c >> (2 * k)) & 3) + 1;
+                for (int b = 0; b < 4; b++)
+                    shuffle[c][4 * k + b] = b < len ? pos + b : 0x80;
+                pos += len;
+            }
+            length[c] = pos;
+        }
+    }
+};
+
+inline const Tables &tables() {
+    static const Tables t;
+    return t;
+}
+
+// Decodes one full group of four into out, continuing the running sum prev.
+// Returns the data bytes consumed.
+inline int decodeGroupScalar(uint8_t control, const uint8_t *data, uint32_t &prev, uint32_t *out) {
+    const uint8_t *p = data;
+    for (int k = 0; k < 4; k++)
+    {
+        int len = ((control >> (2 * k)) & 3) + 1;
+        uint32_t delta = 0;
+        memcpy(&delta, p, len); // little-endian
+        p += len;
+        prev += delta;
+        out[k] = prev;
+    }
+    return p - data;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("ssse3")))
+inline int decodeGroupSSSE3(uint8_t control, const uint8_t *data, uint32_t &prev, uint32_t *out) {
+    const Tables &t = tables();
+    __m128i bytes = _mm_loadu_si128((const __m128i *)data);
+    __m128i deltas = _mm_shuffle_epi8(bytes, _mm_loadu_si128((const __m128i *)t.shuffle[control]));
+
+    // Inclusive prefix sum of the four lanes, then add the running total.
+    deltas = _mm_add_epi32(deltas, _mm_slli_si128(deltas, 4));
+    deltas = _mm_add_epi32(deltas, _mm_slli_si128(deltas, 8));
+    __m128i values = _mm_add_epi32(deltas, _mm_set1_epi32(prev));
+    _mm_storeu_si128((__m128i *)out, values);
+
+    prev = out[3];
+    return t.length[control];
+}
+#endif
+
+inline bool haveSSSE3() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+} // namespace svb
+
+class CompressedGraph {
+public:
+    // The SIMD decoder reads 16 bytes from the start of any group.
+    static const int PADDING = 16;
+
+    CompressedGraph() = default;
+
+    explicit CompressedGraph(const std::vector<std::vector<int>> &adj) {
+        int n = adj.size();
+        degrees.resize(n);
+        offsets.assign(n + 1, 0);
+
+        std::vector<uint32_t> sorted;
+        for (int v = 0; v < n; v++)
+        {
+            sorted.assign(adj[v].begin(), adj[v].end());
+            std::sort(sorted.begin(), sorted.end());
+            degrees[v] = sorted.size();
+            encodeList(sorted);
+            offsets[v + 1] = bytes.size();
+        }
+        bytes.resize(bytes.size() + PADDING, 0);
+        bytes.shrink_to_fit();
+        useSIMD = svb::haveSSSE3();
+    }
+
+    int size() const { return degrees.size(); }
+    int degree(int v) const { return degrees[v]; }
+
+    // Compressed bytes, counting the per-vertex offsets and degrees.
+    size_t memoryBytes() const {
+        return bytes.size() + offsets.size() * sizeof(uint64_t) + degrees.size() * sizeof(uint32_t);
+    }
+
+    // Forces the scalar decoder, e.g. for benchmarking.
+    void setSIMD(bool enabled) { useSIMD = enabled && svb::haveSSSE3(); }
+    bool simdEnabled() const { return useSIMD; }
+
+    // Calls f(neighbor) for every neighbor of v in ascending order, decoding
+    // four at a time without materializing the list.
+    template <typename F>
+    void forEachNeighbor(int v, F f) const {
+        uint32_t count = degrees[v];
+        const uint8_t *control = bytes.data() + offsets[v];
+        const uint8_t *data = control + (count + 3) / 4;
+        uint32_t prev = 0;
+        uint32_t group[4];
+
+        uint32_t full = count / 4;
+        for (uint32_t g = 0; g < full; g++)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if (useSIMD)
+                data += svb::decodeGroupSSSE3(control[g], data, prev, group);
+            else
+#endif
+                data += svb::decodeGroupScalar(control[g], data, prev, group);
+            f((int)group[0]);
+            f((int)group[1]);
+            f((int)group[2]);
+            f((int)group[3]);
+        }
+
+        uint32_t tail = count - 4 * full;
+        for (uint32_t k = 0; k < tail; k++)
+        {
+            int len = ((control[full] >> (2 * k)) & 3) + 1;
+            uint32_t delta = 0;
+            memcpy(&delta, data, len);
+            data += len;
+            prev += delta;
+            f((int)prev);
+        }
+    }
+
+    // Decodes v's list into out (replacing its contents).
+    void neighbors(int v, std::vector<int> &out) const {
+        out.clear();
+        forEachNeighbor(v, [&](int u) { out.push_back(u); });
+    }
+
+private:
+    void encodeList(const std::vector<uint32_t> &sorted) {
+        size_t count = sorted.size();
+        size_t controlStart = bytes.size();
+        bytes.resize(controlStart + (count + 3) / 4, 0);
+
+        uint32_t prev = 0;
+        for (size_t k = 0; k < count; k++)
+        {
+            uint32_t delta = sorted[k] - prev;
+            prev = sorted[k];
+            int code = svb::lengthCode(delta);
+            bytes[controlStart + k / 4] |= code << (2 * (k % 4));
+            for (int b = 0; b <= code; b++)
+                bytes.push_back((delta >> (8 * b)) & 0xFF);
+        }
+    }
+
+    std::vector<uint8_t> bytes;    // control bytes then data bytes, per vertex
+    std::vector<uint64_t> offsets; // vertex -> start of its control bytes
+    std::vector<uint32_t> degrees;
+    bool useSIMD = false;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Compressed sparse row graph: the neighbors of v are
+// neighbors[offsets[v] .. offsets[v + 1]), in the order of the source lists.
+// Flat arrays keep each list contiguous for the iterative and SIMD engines.
+// The allocator is a parameter so the arrays can live in an Arena.
+
+template <template <typename> class Alloc>
+struct BasicCSRGraph {
+    std::vector<int64_t, Alloc<int64_t>> offsets;
+    std::vector<int, Alloc<int>> neighbors;
+
+    explicit BasicCSRGraph(const Alloc<int> &alloc = Alloc<int>())
+        : offsets(Alloc<int64_t>(alloc)), neighbors(alloc) {}
+
+    explicit BasicCSRGraph(const std::vector<std::vector<int>> &adj, const Alloc<int> &alloc = Alloc<int>())
+        : BasicCSRGraph(alloc) {
+        offsets.assign(adj.size() + 1, 0);
+        for (size_t v = 0; v < adj.size(); v++)
+            offsets[v + 1] = offsets[v] + adj[v].size();
+        neighbors.reserve(offsets.back());
+        for (const std::vector<int> &list : adj)
+            neighbors.insert(neighbors.end(), list.begin(), list.end());
+    }
+
+    // Builds the graph from generate(v, emit), which must call emit(u) for
+    // every edge v -> u and produce the same edges when called again. Two
+    // passes (count, then fill) size both arrays exactly, so nothing is
+    // reallocated while building.
+    template <typename Generator>
+    void assign(int numVertices, Generator generate) {
+        offsets.assign(numVertices + 1, 0);
+        for (int v = 0; v < numVertices; v++)
+        {
+            int64_t degree = 0;
+            generate(v, [&](int) { degree++; });
+            offsets[v + 1] = offsets[v] + degree;
+        }
+        neighbors.resize(offsets.back());
+        for (int v = 0; v < numVertices; v++)
+        {
+            int *out = neighbors.data() + offsets[v];
+            generate(v, [&](int u) { *out++ = u; });
+        }
+    }
+
+    int size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    int64_t numEdges() const { return neighbors.size(); }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    const int *begin(int v) const { return neighbors.data() + offsets[v]; }
+    const int *end(int v) const { return neighbors.data() + offsets[v + 1]; }
+    void prefetchIndex(int v) const { __builtin_prefetch(&offsets[v]); }
+};
+
+typedef BasicCSRGraph<std::allocator> CSRGraph;
@@ -0,0 +1,673 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <sched.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "csr_graph.h"
+#include "arena.h"
+#include "compressed_graph.h"
+#include "simd_filter.h"
+#include "traversal_context.h"
+#include "affinity.h"
+
+// Header-only DFS engine shared by the serial, OpenMP, work-stealing and
+// MPI programs.
+//
+// One traversal loop (dfsDrain) is templated on three things, all resolved
+// at compile time so the hot loop has no virtual calls:
+//
+//   Graph    anything GraphTraits knows: adjacency lists, CSRGraph (any
+//            allocator), NumaCSRGraph, CompressedGraph, OutOfCoreGraph
+//   Visited  isVisited(v) / markVisited(v); SequentialVisited,
+//            BitmapVisited, AtomicVisited or ContextVisited over a
+//            TraversalContext
+//   Visitor  hooks derived from DfsVisitor: discover(v) for each visited
+//            vertex, follow(u) to filter edges, stopRequested() for early
+//            exit, beginTraversal(numThreads) before a run
+//
+// The execution policy picks the dfsRun overload: Sequential (stack on the
+// heap or in an Arena), OmpTasks (stack halves handed out as OpenMP tasks)
+// or WorkStealing (pinned threads with per-thread stacks and node-aware
+// stealing). The MPI engines run the same loop on their own partition: the
+// bulk-synchronous one calls dfsFromRoot per root with a visitor that skips
+// remote vertices, the asynchronous one calls dfsDrain with a visitor that
+// forwards them to their owners. dfsOutOfCore (out_of_core.h) drains one
+// block's worth of the frontier at a time.
+//
+// Neighbors are visited in list order, or with stride > 1 every stride-th
+// neighbor first and then the rest, as in serial.cpp and parallel.cpp.
+//
+// pushNeighbors is the one neighbor loop of every policy and of the MPI
+// and out-of-core paths. For graphs with contiguous neighbor lists and
+// stride 1 it drops visited neighbors with one SIMD filter call per list
+// (simd_filter.h) and only asks the visitor about the survivors; otherwise
+// it checks visited before asking the visitor too. With a prefetch distance
+// set it also prefetches the graph and visited entries of the vertices
+// that will pop next; that only pays off on graphs far larger than cache,
+// so it is off by default.
+
+inline int engineThreadNum() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+inline int engineMaxThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// The busy loop the benchmarks have always run per vertex to stand in for
+// real work.
+inline double simulatedWork(int v) {
+    double work = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        work += (v * i) % 100;
+    }
+    return work;
+}
+
+// Graph access
+
+template <typename Graph>
+struct GraphTraits {
+    static const bool contiguous = true; // neighborsBegin/End are available
+
+    static int numVertices(const Graph &g) { return g.size(); }
+
+    template <typename F>
+    static void forEachNeighbor(const Graph &g, int v, F f) {
+        for (const int *it = g.begin(v); it != g.end(v); ++it)
+            f(*it);
+    }
+
+    // Random access to the neighbor list, for resumable traversals.
+    static const int *neighborsBegin(const Graph &g, int v) { return g.begin(v); }
+    static const int *neighborsEnd(const Graph &g, int v) { return g.end(v); }
+    static void prefetchIndex(const Graph &g, int v) { g.prefetchIndex(v); }
+};
+
+template <>
+struct GraphTraits<std::vector<std::vector<int>>> {
+    static const bool contiguous = true;
+
+    static int numVertices(const std::vector<std::vector<int>> &g) { return g.size(); }
+
+    template <typename F>
+    static void forEachNeighbor(const std::vector<std::vector<int>> &g, int v, F f) {
+        for (int u : g[v])
+            f(u);
+    }
+
+    static const int *neighborsBegin(const std::vector<std::vector<int>> &g, int v) { return g[v].data(); }
+    static const int *neighborsEnd(const std::vector<std::vector<int>> &g, int v) {
+        return g[v].data() + g[v].size();
+    }
+    static void prefetchIndex(const std::vector<std::vector<int>> &g, int v) { __builtin_prefetch(&g[v]); }
+};
+
+template <>
+struct GraphTraits<CompressedGraph> {
+    static const bool contiguous = false;
+
+    static int numVertices(const CompressedGraph &g) { return g.size(); }
+
+    template <typename F>
+    static void forEachNeighbor(const CompressedGraph &g, int v, F f) {
+        g.forEachNeighbor(v, f);
+    }
+};
+
+// Visited sets. Besides isVisited/markVisited each one offers view() for
+// the neighbor filter and prefetch(v). Byte flags are padded to a multiple
+// of 4 for the filter kernels.
+
+inline size_t paddedFlagCount(int n) { return ((size_t)n + 3) & ~(size_t)3; }
+
+class SequentialVisited {
+public:
+    explicit SequentialVisited(int n) : flags(paddedFlagCount(n), 0) {}
+
+    bool isVisited(int v) const { return flags[v]; }
+    VisitedView view() const { return VisitedView::bytes(flags.data()); }
+    void prefetch(int v) const { __builtin_prefetch(&flags[v]); }
+    bool markVisited(int v) {
+        if (flags[v])
+            return false;
+        flags[v] = 1;
+        return true;
+    }
+
+private:
+    std::vector<char> flags;
+};
+
+// One bit per vertex, for graphs too large for a byte each.
+class BitmapVisited {
+public:
+    explicit BitmapVisited(int n) : bits(n) {}
+
+    bool isVisited(int v) const { return bits.test(v); }
+    VisitedView view() const { return VisitedView::bits(bits.data()); }
+    void prefetch(int v) const { __builtin_prefetch(bits.data() + (v >> 5)); }
+    bool markVisited(int v) {
+        if (bits.test(v))
+            return false;
+        bits.set(v);
+        return true;
+    }
+
+private:
+    VisitedBits bits;
+};
+
+// Safe for concurrent markVisited; can wrap an array owned elsewhere, which
+// should be padded with paddedFlagCount for the SIMD filter.
+class AtomicVisited {
+public:
+    explicit AtomicVisited(int n) : owned(paddedFlagCount(n), 0), flags(owned.data()) {}
+    explicit AtomicVisited(char *external) : flags(external) {}
+
+    AtomicVisited(const AtomicVisited &) = delete;
+    AtomicVisited &operator=(const AtomicVisited &) = delete;
+
+    bool isVisited(int v) const { return flags[v]; }
+    VisitedView view() const { return VisitedView::bytes(flags); }
+    void prefetch(int v) const { __builtin_prefetch(&flags[v]); }
+    bool markVisited(int v) {
+        char old;
+        #pragma omp atomic capture
+        {
+            old = flags[v];
+            flags[v] = 1;
+        }
+        return !old;
+    }
+
+private:
+    std::vector<char> owned;
+    char *flags;
+};
+
+// Epoch stamps of a TraversalContext; call ctx.begin() before the run.
+template <bool Concurrent>
+class ContextVisited {
+public:
+    explicit ContextVisited(TraversalContext &ctx) : ctx(ctx) {}
+
+    bool isVisited(int v) const { return ctx.isVisited(v); }
+    bool markVisited(int v) { return Concurrent ? ctx.claimVisited(v) : ctx.markVisited(v); }
+    VisitedView view() const { return VisitedView::stamps(ctx.stamps(), ctx.currentEpoch()); }
+    void prefetch(int v) const { __builtin_prefetch(ctx.stamps() + v); }
+
+private:
+    TraversalContext &ctx;
+};
+
+// Visitors
+
+// Default hooks; visitors derive from this and hide what they need. Under
+// the parallel policies hooks are called concurrently from all threads.
+struct DfsVisitor {
+    void beginTraversal(int) {}
+    bool stopRequested() const { return false; }
+    bool follow(int) { return true; }  // false: do not traverse this edge
+    bool discover(int) { return true; } // false: stop the whole traversal
+};
+
+// Records the visit order, one buffer per thread, optionally running
+// simulatedWork on every vertex as the benchmarks do. There are
+// engineMaxThreads() buffers up front, so dfsFromRoot can be called without
+// beginTraversal; WorkStealing may run more threads than that and relies on
+// beginTraversal to add theirs.
+class OrderCollector : public DfsVisitor {
+public:
+    explicit OrderCollector(bool simulateWork = false)
+        : simulateWork(simulateWork), perThread(engineMaxThreads()) {}
+
+    void beginTraversal(int numThreads) {
+        perThread.resize(std::max<size_t>(perThread.size(), numThreads));
+        for (std::vector<int> &part : perThread)
+            part.clear();
+    }
+
+    bool discover(int v) {
+        perThread[engineThreadNum()].push_back(v);
+        if (simulateWork)
+            simulatedWork(v);
+        return true;
+    }
+
+    // Appends the visits to out, thread by thread.
+    void appendOrder(std::vector<int> &out) const {
+        for (const std::vector<int> &part : perThread)
+            out.insert(out.end(), part.begin(), part.end());
+    }
+
+    std::vector<int> order() const {
+        std::vector<int> out;
+        appendOrder(out);
+        return out;
+    }
+
+private:
+    bool simulateWork;
+    std::vector<std::vector<int>> perThread;
+};
+
+struct DfsOptions {
+    int stride = 1;
+    FilterKernel filter = bestFilterKernel(); // neighbor filter kernel
+    int prefetchDistance = 0;                 // stack entries to prefetch ahead; 0 is off
+};
+
+// Core loop
+
+// Prefetches for the stack entries the traversal will pop soon, as a
+// three-stage pipeline: the entry `distance` below the top gets its index
+// entry and visited flag fetched, the one half as deep the start of its
+// neighbor list (whose index entry should have arrived by then), and the
+// one a quarter as deep the visited flags of its first neighbors.
+template <typename Graph, typename Visited, typename Stack>
+inline void prefetchUpcoming(const Graph &g, const Visited &visited, const Stack &stack, int distance) {
+    size_t top = stack.size();
+    if (top > (size_t)distance)
+    {
+        int u = stack[top - 1 - distance];
+        GraphTraits<Graph>::prefetchIndex(g, u);
+        visited.prefetch(u);
+    }
+    if (top > (size_t)distance / 2)
+        __builtin_prefetch(GraphTraits<Graph>::neighborsBegin(g, stack[top - 1 - distance / 2]));
+    if (top > (size_t)distance / 4)
+    {
+        int u = stack[top - 1 - distance / 4];
+        const int *first = GraphTraits<Graph>::neighborsBegin(g, u);
+        const int *last = std::min(GraphTraits<Graph>::neighborsEnd(g, u), first + 8);
+        for (const int *it = first; it < last; it++)
+            visited.prefetch(*it);
+    }
+}
+
+// True when Visitor keeps DfsVisitor::follow, so every edge is followed.
+template <typename Visitor>
+struct FollowsEveryEdge : std::is_same<decltype(&Visitor::follow), bool (DfsVisitor::*)(int)> {};
+
+// Pushes v's followable, unvisited neighbors so that they pop in visit order.
+template <typename Graph, typename Visited, typename Stack, typename Visitor>
+inline void pushNeighbors(const Graph &g, int v, Visited &visited, Stack &stack,
+                          Visitor &visitor, const DfsOptions &options) {
+    size_t first = stack.size();
+    auto push = [&](int u) {
+        if (!visited.isVisited(u) && visitor.follow(u))
+            stack.push_back(u);
+    };
+    int stride = options.stride;
+
+    if constexpr (GraphTraits<Graph>::contiguous)
+    {
+        if (stride <= 1)
+        {
+            // Filter straight onto the stack, then let the visitor veto.
+            const int *begin = GraphTraits<Graph>::neighborsBegin(g, v);
+            size_t degree = GraphTraits<Graph>::neighborsEnd(g, v) - begin;
+            stack.resize(first + degree + FILTER_SLACK);
+            size_t kept = filterNeighbors(options.filter, visited.view(), begin, degree, stack.data() + first);
+            if (!FollowsEveryEdge<Visitor>::value)
+            {
+                size_t k = first;
+                for (size_t i = first; i < first + kept; i++)
+                    if (visitor.follow(stack[i]))
+                        stack[k++] = stack[i];
+                kept = k - first;
+            }
+            stack.resize(first + kept);
+            std::reverse(stack.begin() + first, stack.end());
+            if (options.prefetchDistance > 0)
+                prefetchUpcoming(g, visited, stack, options.prefetchDistance);
+            return;
+        }
+    }
+
+    if (stride <= 1)
+    {
+        GraphTraits<Graph>::forEachNeighbor(g, v, push);
+    }
+    else
+    {
+        int idx = 0;
+        GraphTraits<Graph>::forEachNeighbor(g, v, [&](int u) {
+            if (idx++ % stride == 0)
+                push(u);
+        });
+        idx = 0;
+        GraphTraits<Graph>::forEachNeighbor(g, v, [&](int u) {
+            if (idx++ % stride != 0)
+                push(u);
+        });
+    }
+    std::reverse(stack.begin() + first, stack.end());
+}
+
+// Runs DFS until the stack is empty. Returns true if the visitor stopped it.
+template <typename Graph, typename Visited, typename Stack, typename Visitor>
+inline bool dfsDrain(const Graph &g, Visited &visited, Stack &stack, Visitor &visitor,
+                     DfsOptions options = DfsOptions()) {
+    options.filter = usableFilterKernel(options.filter);
+    while (!stack.empty())
+    {
+        if (visitor.stopRequested())
+            return true;
+        int v = stack.back();
+        stack.pop_back();
+        if (!visited.markVisited(v))
+            continue;
+        if (!visitor.discover(v))
+            return true;
+        pushNeighbors(g, v, visited, stack, visitor, options);
+    }
+    return false;
+}
+
+template <typename Graph, typename Visited, typename Stack, typename Visitor>
+inline bool dfsFromRoot(const Graph &g, int root, Visited &visited, Stack &stack, Visitor &visitor,
+                        const DfsOptions &options = DfsOptions()) {
+    stack.clear();
+    stack.push_back(root);
+    return dfsDrain(g, visited, stack, visitor, options);
+}
+
+// dfsFromRoot over a TraversalContext, collecting the order in ctx.result().
+// The returned reference stays valid until ctx's next traversal.
+template <typename Graph>
+inline const std::vector<int> &dfsFrom(const Graph &g, int source, TraversalContext &ctx) {
+    struct ResultCollector : DfsVisitor {
+        std::vector<int> &res;
+        explicit ResultCollector(std::vector<int> &res) : res(res) {}
+        bool discover(int v) {
+            res.push_back(v);
+            return true;
+        }
+    };
+
+    ctx.begin(GraphTraits<Graph>::numVertices(g));
+    ContextVisited<false> visited(ctx);
+    ResultCollector collector(ctx.result());
+    dfsFromRoot(g, source, visited, ctx.scratchStack(), collector);
+    return ctx.result();
+}
+
+// Execution policies
+
+struct Sequential {
+    Arena *arena = nullptr; // stack storage; null means the heap
+};
+
+struct OmpTasks {
+    int splitThreshold = 256; // stack size at which half of it becomes a task
+};
+
+struct StealStats {
+    long long localSteals = 0;  // from a thread on the same node
+    long long remoteSteals = 0; // across nodes
+};
+
+struct WorkStealing {
+    int numThreads = 1;
+    std::vector<int> threadNode; // node of each thread; empty means all on one node
+    std::vector<int> threadCpu;  // CPU to pin each thread to; empty means no pinning
+    StealStats *stats = nullptr;
+};
+
+template <typename Graph, typename Visited, typename Stack, typename Visitor>
+inline void dfsAllRoots(const Graph &g, Visited &visited, Stack &stack, Visitor &visitor, const DfsOptions &options) {
+    int n = GraphTraits<Graph>::numVertices(g);
+    for (int root = 0; root < n; root++)
+        if (!visited.isVisited(root) && dfsFromRoot(g, root, visited, stack, visitor, options))
+            return;
+}
+
+template <typename Graph, typename Visited, typename Visitor>
+inline void dfsRunWith(const Sequential &policy, const Graph &g, Visited &visited, Visitor &visitor,
+                       DfsOptions options = DfsOptions()) {
+    visitor.beginTraversal(1);
+    if (policy.arena)
+    {
+        ArenaVector<int> stack{ArenaAllocator<int>(*policy.arena)};
+        dfsAllRoots(g, visited, stack, visitor, options);
+    }
+    else
+    {
+        std::vector<int> stack;
+        dfsAllRoots(g, visited, stack, visitor, options);
+    }
+}
+
+template <typename Graph, typename Visited, typename Visitor>
+inline void ompTaskDrain(const Graph &g, std::vector<int> stack, Visited &visited, Visitor &visitor,
+                         const OmpTasks &policy, const DfsOptions &options, bool &stopped) {
+    while (!stack.empty())
+    {
+        bool stop;
+        #pragma omp atomic read
+        stop = stopped;
+        if (stop || visitor.stopRequested())
+            return;
+
+        int v = stack.back();
+        stack.pop_back();
+        if (!visited.markVisited(v))
+            continue;
+        if (!visitor.discover(v))
+        {
+            #pragma omp atomic write
+            stopped = true;
+            return;
+        }
+        pushNeighbors(g, v, visited, stack, visitor, options);
+
+        if ((int)stack.size() > policy.splitThreshold)
+        {
+            // The bottom half is what this task would reach last.
+            size_t half = stack.size() / 2;
+            std::vector<int> part(stack.begin(), stack.begin() + half);
+            stack.erase(stack.begin(), stack.begin() + half);
+            #pragma omp task firstprivate(part) shared(g, visited, visitor, policy, options, stopped)
+            ompTaskDrain(g, std::move(part), visited, visitor, policy, options, stopped);
+        }
+    }
+}
+
+template <typename Graph, typename Visited, typename Visitor>
+inline void dfsRunWith(const OmpTasks &policy, const Graph &g, Visited &visited, Visitor &visitor,
+                       DfsOptions options = DfsOptions()) {
+    visitor.beginTraversal(engineMaxThreads());
+    options.filter = usableFilterKernel(options.filter);
+    int n = GraphTraits<Graph>::numVertices(g);
+    bool stopped = false;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            for (int root = 0; root < n && !stopped; root++)
+            {
+                if (visited.isVisited(root))
+                    continue;
+                #pragma omp taskgroup
+                {
+                    ompTaskDrain(g, std::vector<int>(1, root), visited, visitor, policy, options, stopped);
+                }
+            }
+        }
+    }
+}
+
+#ifdef _OPENMP
+// Each thread runs DFS from the roots in its slice of the vertex range with
+// a private stack. When others are hungry it moves the bottom half of that
+// stack to its shared pool; a hungry thread checks its own pool, then pools
+// on its node, then the rest.
+//
+// `outstanding` counts the threads that still have work plus the pools that
+// are full. Filling a pool adds one and is done by a thread that has work;
+// taking a pool moves the count from the pool to the thread; a thread whose
+// stack and roots run out subtracts itself. Zero therefore means no stack,
+// root or pool holds work, and nothing can create more, so threads only
+// leave when it reaches zero or the visitor stops the run.
+template <typename Graph, typename Visited, typename Visitor>
+inline void dfsRunWith(const WorkStealing &policy, const Graph &g, Visited &visited, Visitor &visitor,
+                       DfsOptions options = DfsOptions()) {
+    const int SHARE_INTERVAL = 64; // visits between checks for hungry threads
+    int n = GraphTraits<Graph>::numVertices(g);
+    int numThreads = policy.numThreads;
+    options.filter = usableFilterKernel(options.filter);
+    std::vector<int> threadNode = policy.threadNode;
+    threadNode.resize(numThreads, 0);
+
+    visitor.beginTraversal(numThreads);
+    std::vector<std::vector<int>> pools(numThreads);
+    std::vector<omp_lock_t> poolLocks(numThreads);
+    for (omp_lock_t &lock : poolLocks)
+        omp_init_lock(&lock);
+    std::atomic<int> hungry(0);
+    std::atomic<int> outstanding(numThreads);
+    std::atomic<bool> stopped(false);
+    long long localSteals = 0, remoteSteals = 0;
+
+    std::vector<std::vector<int>> victims(numThreads);
+    for (int t = 0; t < numThreads; t++)
+    {
+        for (int k = 0; k < numThreads; k++)
+            victims[t].push_back((t + k) % numThreads);
+        std::stable_sort(victims[t].begin(), victims[t].end(), [&](int a, int b) {
+            return (threadNode[a] != threadNode[t]) < (threadNode[b] != threadNode[t]);
+        });
+    }
+
+    #pragma omp parallel num_threads(numThreads) reduction(+ : localSteals, remoteSteals)
+    {
+        AffinityGuard guard;
+        int t = omp_get_thread_num();
+        if ((int)policy.threadCpu.size() > t)
+            pinThreadToCpu(policy.threadCpu[t]);
+
+        int rootEnd = (long long)n * (t + 1) / numThreads;
+        int nextRoot = (long long)n * t / numThreads;
+        std::vector<int> stack;
+        int sinceShare = 0;
+        bool isHungry = false;
+
+        while (!stopped.load(std::memory_order_relaxed))
+        {
+            if (stack.empty())
+            {
+                while (nextRoot < rootEnd && visited.isVisited(nextRoot))
+                    nextRoot++;
+                if (nextRoot < rootEnd)
+                    stack.push_back(nextRoot++);
+            }
+
+            if (stack.empty())
+            {
+                if (!isHungry)
+                {
+                    isHungry = true;
+                    hungry++;
+                    outstanding--;
+                }
+                for (int victim : victims[t])
+                {
+                    // The pool's share of outstanding becomes this thread's.
+                    omp_set_lock(&poolLocks[victim]);
+                    stack.swap(pools[victim]);
+                    omp_unset_lock(&poolLocks[victim]);
+                    if (!stack.empty())
+                    {
+                        if (victim != t && threadNode[victim] == threadNode[t])
+                            localSteals++;
+                        else if (victim != t)
+                            remoteSteals++;
+                        break;
+                    }
+                }
+                if (stack.empty())
+                {
+                    if (outstanding.load() == 0)
+                        break;
+                    sched_yield();
+                    continue;
+                }
+                isHungry = false;
+                hungry--;
+            }
+
+            if (visitor.stopRequested())
+            {
+                stopped = true;
+                break;
+            }
+            int v = stack.back();
+            stack.pop_back();
+            if (!visited.markVisited(v))
+                continue;
+            if (!visitor.discover(v))
+            {
+                stopped = true;
+                break;
+            }
+            pushNeighbors(g, v, visited, stack, visitor, options);
+
+            if (++sinceShare >= SHARE_INTERVAL)
+            {
+                sinceShare = 0;
+                if (hungry.load(std::memory_order_relaxed) > 0 && stack.size() > 16)
+                {
+                    omp_set_lock(&poolLocks[t]);
+                    if (pools[t].empty())
+                    {
+                        size_t half = stack.size() / 2;
+                        pools[t].assign(stack.begin(), stack.begin() + half);
+                        stack.erase(stack.begin(), stack.begin() + half);
+                        outstanding++;
+                    }
+                    omp_unset_lock(&poolLocks[t]);
+                }
+            }
+        }
+    }
+
+    for (omp_lock_t &lock : poolLocks)
+        omp_destroy_lock(&lock);
+    if (policy.stats)
+    {
+        policy.stats->localSteals = localSteals;
+        policy.stats->remoteSteals = remoteSteals;
+    }
+}
+#endif
+
+// Runs with a fresh visited set suited to the policy.
+template <typename Graph, typename Visitor>
+inline void dfsRun(const Sequential &policy, const Graph &g, Visitor &visitor, DfsOptions options = DfsOptions()) {
+    SequentialVisited visited(GraphTraits<Graph>::numVertices(g));
+    dfsRunWith(policy, g, visited, visitor, options);
+}
+
+template <typename Policy, typename Graph, typename Visitor>
+inline void dfsRun(const Policy &policy, const Graph &g, Visitor &visitor, DfsOptions options = DfsOptions()) {
+    AtomicVisited visited(GraphTraits<Graph>::numVertices(g));
+    dfsRunWith(policy, g, visited, visitor, options);
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <vector>
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <utility>
+#include <cstddef>
+#include "dfs_engine.h"
+
+// Lazy DFS: a C++20 generator that yields vertices in DFS order as the
+// caller asks for them.
+//
+// dfs() and the engine build the whole visit order before returning. Here
+// the traversal is a coroutine suspended after every vertex, so a consumer
+// that only needs a prefix, or filters as it goes, pays only for what it
+// pulls. Leaving a range-for early destroys the coroutine and its state.
+//
+// The coroutine keeps one frame per level of the current path, (vertex,
+// next neighbor to try), like the call stack of the recursive engines,
+// instead of an explicit stack of every pending neighbor. Besides a
+// visited bit per vertex, memory is O(depth). The order is the order of
+// the recursive engines.
+//
+//   for (int v : dfsLazyFrom(adj, source))
+//       if (++seen == k) break;
+//
+// takeFirst(gen, k) collects a prefix; a later loop over gen continues
+// where it stopped.
+//
+// Graphs need random access to their neighbor lists (adjacency lists or any
+// CSR layout); CompressedGraph can only be decoded a whole list at a time.
+
+template <typename T>
+class Generator {
+public:
+    struct promise_type {
+        T current;
+        std::exception_ptr error;
+
+        Generator get_return_object() {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T value) noexcept {
+            current = std::move(value);
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    class iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        iterator() = default;
+        explicit iterator(Handle handle) : handle(handle) {}
+
+        const T &operator*() const { return handle.promise().current; }
+        iterator &operator++() {
+            advance(handle);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return !handle || handle.done(); }
+
+    private:
+        Handle handle;
+    };
+
+    explicit Generator(Handle handle) : handle(handle) {}
+    Generator(Generator &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Generator &operator=(Generator &&other) noexcept {
+        if (this != &other)
+        {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    ~Generator() {
+        if (handle)
+            handle.destroy();
+    }
+
+    // Moves to the next value, so a loop that broke out early can be
+    // followed by another that continues after the last value it saw.
+    iterator begin() {
+        if (handle && !handle.done())
+            advance(handle);
+        return iterator(handle);
+    }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    static void advance(Handle handle) {
+        handle.resume();
+        if (handle.promise().error)
+            std::rethrow_exception(handle.promise().error);
+    }
+
+    Handle handle;
+};
+
+// Collects at most k values, leaving the rest of the sequence unevaluated.
+template <typename T>
+inline std::vector<T> takeFirst(Generator<T> &gen, size_t k) {
+    std::vector<T> out;
+    if (k == 0)
+        return out;
+    for (const T &value : gen)
+    {
+        out.push_back(value);
+        if (out.size() == k)
+            break;
+    }
+    return out;
+}
+
+// Frames of the path from the root of the current tree.
+struct LazyDfsFrame {
+    const int *next;
+    const int *end;
+};
+
+// Trees rooted at source only, or at every unvisited vertex in turn when
+// wholeGraph is set. Yields nothing for a source outside [0, n).
+template <typename Graph>
+Generator<int> lazyDfs(const Graph &g, int source, bool wholeGraph) {
+    typedef GraphTraits<Graph> Traits;
+    int n = Traits::numVertices(g);
+    if (!wholeGraph && (source < 0 || source >= n))
+        co_return;
+    std::vector<bool> visited(n, false);
+    std::vector<LazyDfsFrame> path;
+
+    for (int i = 0; i < (wholeGraph ? n : 1); i++)
+    {
+        int root = wholeGraph ? i : source;
+        if (visited[root])
+            continue;
+        visited[root] = true;
+        co_yield root;
+        path.push_back({Traits::neighborsBegin(g, root), Traits::neighborsEnd(g, root)});
+
+        while (!path.empty())
+        {
+            LazyDfsFrame &top = path.back();
+            if (top.next == top.end)
+            {
+                path.pop_back();
+                continue;
+            }
+            int u = *top.next++;
+            if (visited[u])
+                continue;
+            visited[u] = true;
+            co_yield u;
+            path.push_back({Traits::neighborsBegin(g, u), Traits::neighborsEnd(g, u)});
+        }
+    }
+}
+
+// Vertices reachable from source, lazily in DFS order; empty if source is
+// not a vertex, including on an empty graph. The graph must outlive the
+// generator.
+template <typename Graph>
+inline Generator<int> dfsLazyFrom(const Graph &g, int source) {
+    return lazyDfs(g, source, false);
+}
+
+// Every vertex, lazily, in the order of a full traversal.
+template <typename Graph>
+inline Generator<int> dfsLazy(const Graph &g) {
+    return lazyDfs(g, 0, true);
+}
@@ -0,0 +1,587 @@
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "csr_graph.h"
+#include "dfs_engine.h"
+#include "traversal_context.h"
+#include "out_of_core.h"
+#include "path_search.h"
+#include "server_protocol.h"
+using namespace std;
+
+// Long-running query server: loads the graph once and answers DFS,
+// reachability and path queries over a Unix domain socket (protocol in
+// server_protocol.h). The same binary is also a small client.
+//
+// Path queries return a shortest path from a bidirectional search over the
+// graph and its transpose, which is built once at startup. Levels with large
+// frontiers are expanded by pathThreads OpenMP threads of the worker that
+// took the query; by default the cores are split evenly between workers.
+//
+// Each connection has a reader thread, which turns requests into jobs on a
+// shared queue, and a writer thread, which sends the replies workers leave
+// in the connection's outbox. Worker threads, each with its own
+// TraversalContext, take up to MAX_BATCH queued requests at a time.
+// Identical requests within a batch are answered once, and all responses
+// for one connection go out as one outbox entry, so a server under load
+// does less work per request, not more. Workers never touch a socket, so a
+// client that stops reading only stalls its own connection: once its outbox
+// holds MAX_OUTBOX_BYTES or MAX_UNANSWERED of its requests wait for an
+// answer, its reader stops taking requests.
+//
+// On shutdown the readers are stopped with shutdown(SHUT_RD) and joined,
+// the workers answer every request the readers queued and are joined, and
+// the writers send those answers before they are joined.
+
+const size_t MAX_BATCH = 32;
+const size_t MAX_OUTBOX_BYTES = 4 << 20;
+const long long MAX_UNANSWERED = 8 * MAX_BATCH;
+const int SEND_POLL_MS = 200;
+
+class Connection {
+public:
+    const int fd;
+    thread reader;
+    thread writer;
+    atomic<bool> finished{false};   // writer is done; both threads can be joined
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+
+    // Reader: waits until the connection may queue another request. False
+    // once reading stops.
+    bool waitForRoom() {
+        unique_lock<mutex> lock(m);
+        changed.wait(lock, [&] {
+            return (outboxBytes < MAX_OUTBOX_BYTES && unanswered < MAX_UNANSWERED) || !reading;
+        });
+        return reading;
+    }
+
+    // Reader: one more request will get a reply.
+    void expectReply() {
+        lock_guard<mutex> lock(m);
+        unanswered++;
+    }
+
+    // Reader: no more requests will come.
+    void endOfRequests() {
+        {
+            lock_guard<mutex> lock(m);
+            reading = false;
+        }
+        changed.notify_all();
+    }
+
+    // Worker: queues the replies to answered requests for the writer.
+    void queueReply(vector<char>&& bytes, long long answered) {
+        {
+            lock_guard<mutex> lock(m);
+            unanswered -= answered;
+            if (!broken) {
+                outboxBytes += bytes.size();
+                outbox.push_back(move(bytes));
+            }
+        }
+        changed.notify_all();
+    }
+
+    // Server shutdown, first step: wakes the reader wherever it waits.
+    void stopReading() {
+        shutdown(fd, SHUT_RD);
+        {
+            lock_guard<mutex> lock(m);
+            reading = false;
+        }
+        changed.notify_all();
+    }
+
+    // Server shutdown, last step: the writer sends what is queued and ends.
+    void stopWriting() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        changed.notify_all();
+    }
+
+    // Writer thread: sends outbox entries until every request is answered
+    // after the reader ended, the peer is gone or the server stops.
+    void writeLoop() {
+        unique_lock<mutex> lock(m);
+        while (true) {
+            changed.wait(lock, [&] { return !outbox.empty() || stopping || (!reading && unanswered == 0); });
+            if (outbox.empty()) break;
+            vector<char> bytes = move(outbox.front());
+            outbox.pop_front();
+            lock.unlock();
+            bool sent = sendAll(bytes);
+            lock.lock();
+            outboxBytes -= bytes.size();
+            if (!sent) {
+                // The peer is gone: drop what is left and stop the reader
+                broken = true;
+                reading = false;
+                outbox.clear();
+                outboxBytes = 0;
+                shutdown(fd, SHUT_RDWR);
+            }
+            changed.notify_all();
+            if (!sent) break;
+        }
+        finished = true;
+    }
+
+private:
+    // Non-blocking sends, so a peer that never reads cannot hold up shutdown
+    // for more than SEND_POLL_MS.
+    bool sendAll(const vector<char>& bytes) {
+        size_t done = 0;
+        while (done < bytes.size()) {
+            ssize_t sent = ::send(fd, bytes.data() + done, bytes.size() - done, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent > 0) {
+                done += sent;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd pfd = {fd, POLLOUT, 0};
+                if (poll(&pfd, 1, SEND_POLL_MS) == 0 && stopping) return false;
+            } else if (sent < 0 && errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    mutex m;
+    condition_variable changed;
+    deque<vector<char>> outbox;
+    size_t outboxBytes = 0;
+    long long unanswered = 0;   // requests queued as jobs without a reply yet
+    bool reading = true;
+    bool broken = false;
+    atomic<bool> stopping{false};
+};
+
+struct Job {
+    shared_ptr<Connection> conn;   // keeps the socket open until answered
+    QueryRequest request;
+};
+
+class JobQueue {
+public:
+    void push(Job job) {
+        {
+            lock_guard<mutex> lock(m);
+            jobs.push_back(move(job));
+        }
+        ready.notify_one();
+    }
+
+    // Waits for work and takes up to maxJobs. False once closed and empty,
+    // so the workers answer every job queued before close().
+    bool popBatch(vector<Job>& batch, size_t maxJobs) {
+        batch.clear();
+        unique_lock<mutex> lock(m);
+        ready.wait(lock, [&] { return !jobs.empty() || closed; });
+        if (jobs.empty()) return false;
+        while (!jobs.empty() && batch.size() < maxJobs) {
+            batch.push_back(move(jobs.front()));
+            jobs.pop_front();
+        }
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(m);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+
+private:
+    mutex m;
+    condition_variable ready;
+    deque<Job> jobs;
+    bool closed = false;
+};
+
+struct ServerStats {
+    atomic<long long> requests{0};
+    atomic<long long> batches{0};
+    atomic<long long> sharedAnswers{0};   // answered by an identical request in the batch
+};
+
+// Per-worker scratch, reused for every request.
+struct WorkerScratch {
+    TraversalContext ctx;
+    PathScratch path;
+
+    explicit WorkerScratch(int numVertices) : ctx(numVertices) {}
+};
+
+struct LimitedOrder : DfsVisitor {
+    vector<int>& out;
+    uint32_t limit;
+
+    LimitedOrder(vector<int>& out, uint32_t limit) : out(out), limit(limit) {}
+    bool discover(int v) {
+        out.push_back(v);
+        return limit == 0 || out.size() < limit;
+    }
+};
+
+struct TargetSearch : DfsVisitor {
+    int target;
+    bool found = false;
+
+    explicit TargetSearch(int target) : target(target) {}
+    bool discover(int v) {
+        found = v == target;
+        return !found;
+    }
+};
+
+QueryStatus answer(const QueryRequest& request, const CSRGraph& graph, const CSRGraph& reverse, int pathThreads,
+                   WorkerScratch& scratch, vector<int>& values) {
+    values.clear();
+    int n = graph.size();
+    QueryOp op = (QueryOp)request.op;
+    bool needsTarget = op == QueryOp::Reach || op == QueryOp::Path;
+    if (op != QueryOp::Info && (request.source < 0 || request.source >= n)) return QueryStatus::BadRequest;
+    if (needsTarget && (request.target < 0 || request.target >= n)) return QueryStatus::BadRequest;
+
+    vector<int>& stack = scratch.ctx.scratchStack();
+    switch (op) {
+    case QueryOp::Info:
+        values = {n, (int)(uint32_t)graph.numEdges(), (int)(uint32_t)(graph.numEdges() >> 32)};
+        return QueryStatus::Ok;
+    case QueryOp::Dfs: {
+        scratch.ctx.begin(n);
+        ContextVisited<false> visited(scratch.ctx);
+        LimitedOrder order(values, request.limit);
+        dfsFromRoot(graph, request.source, visited, stack, order);
+        return QueryStatus::Ok;
+    }
+    case QueryOp::Reach: {
+        scratch.ctx.begin(n);
+        ContextVisited<false> visited(scratch.ctx);
+        TargetSearch search(request.target);
+        dfsFromRoot(graph, request.source, visited, stack, search);
+        values.push_back(search.found ? 1 : 0);
+        return QueryStatus::Ok;
+    }
+    case QueryOp::Path:
+        bidirectionalPathParallel(graph, reverse, request.source, request.target, scratch.path, values, pathThreads);
+        return QueryStatus::Ok;
+    }
+    return QueryStatus::BadRequest;
+}
+
+bool sameQuery(const QueryRequest& a, const QueryRequest& b) {
+    return a.op == b.op && a.source == b.source && a.target == b.target && a.limit == b.limit;
+}
+
+void workerLoop(const CSRGraph& graph, const CSRGraph& reverse, int pathThreads, JobQueue& queue, ServerStats& stats) {
+    WorkerScratch scratch(graph.size());
+    vector<Job> batch;
+    vector<size_t> order;
+    vector<int> values;
+    struct Reply {
+        Connection* conn;
+        vector<char> bytes;
+        long long answered;
+    };
+    vector<Reply> replies;
+
+    while (queue.popBatch(batch, MAX_BATCH)) {
+        // Identical queries next to each other, so each is computed once
+        order.resize(batch.size());
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            const QueryRequest& x = batch[a].request;
+            const QueryRequest& y = batch[b].request;
+            return tie(x.op, x.source, x.target, x.limit) < tie(y.op, y.source, y.target, y.limit);
+        });
+
+        replies.clear();
+        QueryStatus status = QueryStatus::Ok;
+        for (size_t k = 0; k < order.size(); k++) {
+            const Job& job = batch[order[k]];
+            if (k > 0 && sameQuery(job.request, batch[order[k - 1]].request)) {
+                stats.sharedAnswers++;
+            } else {
+                status = answer(job.request, graph, reverse, pathThreads, scratch, values);
+            }
+
+            QueryResponseHeader header;
+            memset(&header, 0, sizeof(header));
+            header.id = job.request.id;
+            header.status = (uint8_t)status;
+            header.count = status == QueryStatus::Ok ? values.size() : 0;
+
+            auto reply = find_if(replies.begin(), replies.end(),
+                                 [&](const Reply& r) { return r.conn == job.conn.get(); });
+            if (reply == replies.end()) {
+                replies.push_back({job.conn.get(), vector<char>(), 0});
+                reply = replies.end() - 1;
+            }
+            const char* headerBytes = (const char*)&header;
+            reply->bytes.insert(reply->bytes.end(), headerBytes, headerBytes + sizeof(header));
+            const char* valueBytes = (const char*)values.data();
+            reply->bytes.insert(reply->bytes.end(), valueBytes, valueBytes + header.count * sizeof(int));
+            reply->answered++;
+        }
+
+        for (Reply& reply : replies) {
+            reply.conn->queueReply(move(reply.bytes), reply.answered);
+        }
+        stats.batches++;
+        stats.requests += batch.size();
+        batch.clear();   // drop the connection references
+    }
+}
+
+void readRequests(shared_ptr<Connection> conn, JobQueue& queue) {
+    QueryRequest request;
+    while (conn->waitForRoom() && readFull(conn->fd, &request, sizeof(request))) {
+        conn->expectReply();
+        queue.push({conn, request});
+    }
+    conn->endOfRequests();
+}
+
+volatile sig_atomic_t stopRequested = 0;
+
+void onSignal(int) { stopRequested = 1; }
+
+// Test graph of the other programs
+void buildDefaultGraph(CSRGraph& graph, int numVertices) {
+    graph.assign(numVertices, [&](int i, auto emit) {
+        int connections = 2 + (i % 3);
+        for (int j = 1; j <= connections; j++) {
+            int neighbor = (i * 7 + j * 13) % numVertices;
+            if (neighbor != i) emit(neighbor);
+        }
+    });
+}
+
+int runServer(const string& socketPath, const string& graphPath, int numVertices, int numWorkers, int pathThreads) {
+    auto loadStart = chrono::steady_clock::now();
+    CSRGraph graph;
+    if (graphPath.empty()) {
+        buildDefaultGraph(graph, numVertices);
+    } else if (!readGraphFile(graphPath, graph)) {
+        cerr << "cannot read graph file " << graphPath << endl;
+        return 1;
+    }
+    CSRGraph reverse = transposeGraph(graph);
+    chrono::duration<double> loadTime = chrono::steady_clock::now() - loadStart;
+    cout << "graph loaded: " << graph.size() << " vertices, " << graph.numEdges() << " edges in "
+         << loadTime.count() * 1000 << " ms" << endl;
+
+    sockaddr_un addr;
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || !socketAddress(socketPath, addr)) {
+        cerr << "bad socket path " << socketPath << endl;
+        return 1;
+    }
+    unlink(socketPath.c_str());
+    if (bind(listenFd, (const sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 128) != 0) {
+        cerr << "cannot listen on " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    JobQueue queue;
+    ServerStats stats;
+    vector<thread> workers;
+    for (int w = 0; w < numWorkers; w++) {
+        workers.emplace_back(workerLoop, cref(graph), cref(reverse), pathThreads, ref(queue), ref(stats));
+    }
+    cout << "listening on " << socketPath << " with " << numWorkers << " workers, " << pathThreads
+         << " thread(s) per path query" << endl;
+
+    vector<shared_ptr<Connection>> connections;
+    while (!stopRequested) {
+        // Join the threads of connections that have ended
+        for (size_t c = 0; c < connections.size();) {
+            if (connections[c]->finished) {
+                connections[c]->reader.join();
+                connections[c]->writer.join();
+                connections[c] = move(connections.back());
+                connections.pop_back();
+            } else {
+                c++;
+            }
+        }
+
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        shared_ptr<Connection> conn = make_shared<Connection>(fd);
+        conn->reader = thread(readRequests, conn, ref(queue));
+        conn->writer = thread(&Connection::writeLoop, conn.get());
+        connections.push_back(move(conn));
+    }
+
+    close(listenFd);
+    unlink(socketPath.c_str());
+    for (shared_ptr<Connection>& conn : connections) conn->stopReading();
+    for (shared_ptr<Connection>& conn : connections) conn->reader.join();
+    queue.close();
+    for (thread& worker : workers) worker.join();
+    for (shared_ptr<Connection>& conn : connections) conn->stopWriting();
+    for (shared_ptr<Connection>& conn : connections) conn->writer.join();
+
+    long long batches = max(1LL, stats.batches.load());
+    cout << "served " << stats.requests.load() << " requests in " << stats.batches.load() << " batches ("
+         << (double)stats.requests.load() / batches << " per batch), " << stats.sharedAnswers.load()
+         << " shared answers" << endl;
+    return 0;
+}
+
+// Sends one query written as info, dfs:S[:LIMIT], reach:S:T or path:S:T.
+int runQuery(const string& socketPath, const string& spec) {
+    vector<string> parts;
+    size_t begin = 0;
+    while (true) {
+        size_t colon = spec.find(':', begin);
+        parts.push_back(spec.substr(begin, colon - begin));
+        if (colon == string::npos) break;
+        begin = colon + 1;
+    }
+
+    QueryRequest request;
+    if (parts[0] == "info") {
+        request = makeRequest(1, QueryOp::Info);
+    } else if (parts[0] == "dfs" && parts.size() >= 2) {
+        request = makeRequest(1, QueryOp::Dfs, atoi(parts[1].c_str()), 0,
+                              parts.size() > 2 ? atoi(parts[2].c_str()) : 0);
+    } else if ((parts[0] == "reach" || parts[0] == "path") && parts.size() == 3) {
+        request = makeRequest(1, parts[0] == "reach" ? QueryOp::Reach : QueryOp::Path,
+                              atoi(parts[1].c_str()), atoi(parts[2].c_str()));
+    } else {
+        cerr << "unknown query " << spec << ", expected info, dfs:S[:LIMIT], reach:S:T or path:S:T" << endl;
+        return 1;
+    }
+
+    int fd = connectToServer(socketPath);
+    if (fd < 0) {
+        cerr << "cannot connect to " << socketPath << endl;
+        return 1;
+    }
+    QueryResponseHeader header;
+    vector<int> values;
+    bool ok = writeFull(fd, &request, sizeof(request)) && readResponse(fd, header, values);
+    close(fd);
+    if (!ok || header.status != (uint8_t)QueryStatus::Ok) {
+        cerr << "query failed" << endl;
+        return 1;
+    }
+
+    if (parts[0] == "info") {
+        cout << "vertices: " << values[0] << ", edges: " << ((int64_t)(uint32_t)values[2] << 32 | (uint32_t)values[1]) << endl;
+    } else if (parts[0] == "reach") {
+        cout << (values[0] ? "reachable" : "not reachable") << endl;
+    } else {
+        cout << values.size() << " vertices:";
+        for (size_t i = 0; i < values.size() && i < 20; i++) cout << " " << values[i];
+        cout << (values.size() > 20 ? " ..." : "") << endl;
+    }
+    return 0;
+}
+
+// Pipelines count DFS queries (1000 vertices each) on one connection.
+int runBenchmark(const string& socketPath, int count) {
+    int fd = connectToServer(socketPath);
+    if (fd < 0) {
+        cerr << "cannot connect to " << socketPath << endl;
+        return 1;
+    }
+    QueryRequest info = makeRequest(0, QueryOp::Info);
+    QueryResponseHeader header;
+    vector<int> values;
+    if (!writeFull(fd, &info, sizeof(info)) || !readResponse(fd, header, values)) {
+        cerr << "server did not answer" << endl;
+        return 1;
+    }
+    int numVertices = values[0];
+
+    auto start = chrono::steady_clock::now();
+    thread sender([&] {
+        for (int q = 0; q < count; q++) {
+            // A few hot sources, as in interactive use
+            int source = (int)((q % 64) * 2654435761LL % numVertices);
+            QueryRequest request = makeRequest(q + 1, QueryOp::Dfs, source, 0, 1000);
+            if (!writeFull(fd, &request, sizeof(request))) break;
+        }
+    });
+    long long received = 0, vertices = 0;
+    while (received < count && readResponse(fd, header, values)) {
+        received++;
+        vertices += values.size();
+    }
+    sender.join();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    close(fd);
+
+    cout << received << " queries in " << elapsed.count() << " seconds, "
+         << received / elapsed.count() << " queries/s, " << (double)vertices / max(1LL, received)
+         << " vertices per answer" << endl;
+    return received == count ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    string socketPath = "/tmp/dfs_server.sock";
+    string graphPath;
+    string query;
+    int numVertices = 50000;
+    int numWorkers = max(1u, thread::hardware_concurrency());
+    int pathThreads = 0;
+    int benchQueries = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--socket=", 9) == 0) {
+            socketPath = argv[i] + 9;
+        } else if (strncmp(argv[i], "--graph=", 8) == 0) {
+            graphPath = argv[i] + 8;
+        } else if (strncmp(argv[i], "--vertices=", 11) == 0) {
+            numVertices = max(1, atoi(argv[i] + 11));
+        } else if (strncmp(argv[i], "--workers=", 10) == 0) {
+            numWorkers = max(1, atoi(argv[i] + 10));
+        } else if (strncmp(argv[i], "--path-threads=", 15) == 0) {
+            pathThreads = max(1, atoi(argv[i] + 15));
+        } else if (strncmp(argv[i], "--query=", 8) == 0) {
+            query = argv[i] + 8;
+        } else if (strncmp(argv[i], "--bench=", 8) == 0) {
+            benchQueries = max(1, atoi(argv[i] + 8));
+        } else {
+            cerr << "unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    if (!query.empty()) return runQuery(socketPath, query);
+    if (benchQueries > 0) return runBenchmark(socketPath, benchQueries);
+    if (pathThreads == 0) pathThreads = max(1, engineMaxThreads() / numWorkers);
+    return runServer(socketPath, graphPath, numVertices, numWorkers, pathThreads);
+}
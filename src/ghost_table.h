@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Per-rank cache of ghost vertices (remote vertices adjacent to local ones)
+// and their last known state, used by the asynchronous MPI engine to avoid
+// sending a remote vertex its owner has already visited.
+//
+// A ghost starts UNKNOWN, becomes SENT once forwarded, and becomes VISITED
+// when its owner reports it. Owners report visits by piggybacking vertex IDs
+// on work batches they send anyway; watchers() tells an owner which ranks
+// hold a given local vertex as a ghost. The whole graph is replicated on
+// every rank, so both directions are derived locally in build().
+
+class GhostTable {
+public:
+    enum State : uint8_t { UNKNOWN = 0, SENT = 1, VISITED = 2 };
+
+    // rankStart[r] .. rankStart[r + 1] is the vertex range owned by rank r.
+    void build(const std::vector<std::vector<int>> &adj, const std::vector<int> &rankStart, int rank) {
+        startVertex = rankStart[rank];
+        endVertex = rankStart[rank + 1];
+        ghostIds.clear();
+        for (int v = startVertex; v < endVertex; v++)
+            for (int neighbor : adj[v])
+                if (!isLocal(neighbor))
+                    ghostIds.push_back(neighbor);
+        std::sort(ghostIds.begin(), ghostIds.end());
+        ghostIds.erase(std::unique(ghostIds.begin(), ghostIds.end()), ghostIds.end());
+        states.assign(ghostIds.size(), UNKNOWN);
+
+        // (local vertex, remote rank) pairs for every cut edge pointing at us
+        std::vector<std::pair<int, int>> watchedBy;
+        for (int u = 0; u < (int)adj.size(); u++)
+        {
+            if (isLocal(u))
+                continue;
+            int uOwner = ownerOf(u, rankStart);
+            for (int neighbor : adj[u])
+                if (isLocal(neighbor))
+                    watchedBy.push_back({neighbor - startVertex, uOwner});
+        }
+        std::sort(watchedBy.begin(), watchedBy.end());
+        watchedBy.erase(std::unique(watchedBy.begin(), watchedBy.end()), watchedBy.end());
+
+        watcherOffsets.assign(endVertex - startVertex + 1, 0);
+        watcherRanks.resize(watchedBy.size());
+        for (size_t k = 0; k < watchedBy.size(); k++)
+        {
+            watcherOffsets[watchedBy[k].first + 1]++;
+            watcherRanks[k] = watchedBy[k].second;
+        }
+        for (int i = 0; i < endVertex - startVertex; i++)
+            watcherOffsets[i + 1] += watcherOffsets[i];
+    }
+
+    // Forgets all ghost states before a new traversal.
+    void reset() { std::fill(states.begin(), states.end(), UNKNOWN); }
+
+    // Index of a ghost vertex, or -1 if it is not adjacent to this rank.
+    int find(int vertex) const {
+        auto it = std::lower_bound(ghostIds.begin(), ghostIds.end(), vertex);
+        if (it == ghostIds.end() || *it != vertex)
+            return -1;
+        return it - ghostIds.begin();
+    }
+
+    State state(int index) const { return (State)states[index]; }
+    void setState(int index, State state) { states[index] = state; }
+
+    // Ranks that hold local vertex v as a ghost
+    const int *watchersBegin(int v) const { return watcherRanks.data() + watcherOffsets[v - startVertex]; }
+    const int *watchersEnd(int v) const { return watcherRanks.data() + watcherOffsets[v - startVertex + 1]; }
+
+    size_t numGhosts() const { return ghostIds.size(); }
+
+private:
+    bool isLocal(int vertex) const { return vertex >= startVertex && vertex < endVertex; }
+
+    static int ownerOf(int vertex, const std::vector<int> &rankStart) {
+        return std::upper_bound(rankStart.begin(), rankStart.end(), vertex) - rankStart.begin() - 1;
+    }
+
+    int startVertex = 0;
+    int endVertex = 0;
+    std::vector<int> ghostIds;       // sorted remote vertex IDs
+    std::vector<uint8_t> states;     // indexed like ghostIds
+    std::vector<int> watcherOffsets; // local index -> range in watcherRanks
+    std::vector<int> watcherRanks;
+};
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "dfs_engine.h"
+
+// DFS forest labels maintained under batched edge insertions and deletions.
+//
+// A full traversal tries roots in ID order, so vertex v ends up in the tree
+// of the smallest vertex that can reach it: label[v] = min { w : w ~> v }.
+// That definition does not depend on neighbor order, which makes it
+// possible to repair labels locally instead of recomputing them:
+//
+//  - inserting u -> v can only lower labels, and only of vertices reachable
+//    from v whose label is above label[u]; they are relabeled by a search
+//    from v that stops wherever a label is already low enough.
+//  - every vertex keeps a parent: the in-neighbor it got its label from.
+//    Parents form a support forest in which each vertex is reached from its
+//    label. Deleting an edge that is not a parent edge changes nothing.
+//    Deleting a parent edge u -> v cuts v's support subtree; only that
+//    subtree is relabeled, seeded from the labels of its in-neighbors
+//    outside it, smallest label first.
+//
+// Support trees are built breadth-first: the labels are the same as with
+// depth-first trees, but the trees are shallow, so a deleted parent edge
+// cuts off few vertices on average.
+
+struct EdgeBatch {
+    std::vector<std::pair<int, int>> insertions;
+    std::vector<std::pair<int, int>> deletions; // applied before the insertions
+};
+
+struct IncrementalStats {
+    long long repairedVertices = 0; // vertices in cut support subtrees
+    long long labelChanges = 0;     // label updates, by repair or insertion
+};
+
+// Tree labels of a full traversal, for checking and as the recompute baseline.
+inline std::vector<int> dfsForestLabels(const std::vector<std::vector<int>> &adj) {
+    struct RootLabeler : DfsVisitor {
+        std::vector<int> &label;
+        int root = 0;
+
+        explicit RootLabeler(std::vector<int> &label) : label(label) {}
+        bool discover(int v) {
+            label[v] = root;
+            return true;
+        }
+    };
+
+    int n = adj.size();
+    std::vector<int> label(n, -1);
+    SequentialVisited visited(n);
+    std::vector<int> stack;
+    RootLabeler labeler(label);
+    for (int root = 0; root < n; root++)
+    {
+        if (visited.isVisited(root))
+            continue;
+        labeler.root = root;
+        dfsFromRoot(adj, root, visited, stack, labeler);
+    }
+    return label;
+}
+
+class DynamicDfsForest {
+public:
+    explicit DynamicDfsForest(std::vector<std::vector<int>> adj) : out(std::move(adj)) {
+        int n = out.size();
+        in.assign(n, std::vector<int>());
+        for (int u = 0; u < n; u++)
+            for (int v : out[u])
+                in[v].push_back(u);
+        inRepair.assign(n, 0);
+        recompute();
+    }
+
+    int size() const { return out.size(); }
+    int label(int v) const { return lab[v]; }
+    int parent(int v) const { return par[v]; } // -1 for tree roots
+    bool sameTree(int u, int v) const { return lab[u] == lab[v]; }
+    int numTrees() const { return roots; }
+    const std::vector<int> &labels() const { return lab; }
+    const std::vector<std::vector<int>> &graph() const { return out; }
+
+    // Rebuilds labels and support trees from scratch.
+    void recompute() {
+        int n = out.size();
+        lab.assign(n, -1);
+        par.assign(n, -1);
+        roots = 0;
+        for (int r = 0; r < n; r++)
+        {
+            if (lab[r] != -1)
+                continue;
+            lab[r] = r;
+            roots++;
+            queue.assign(1, r);
+            for (size_t head = 0; head < queue.size(); head++)
+            {
+                int x = queue[head];
+                for (int y : out[x])
+                {
+                    if (lab[y] == -1)
+                    {
+                        lab[y] = r;
+                        par[y] = x;
+                        queue.push_back(y);
+                    }
+                }
+            }
+        }
+    }
+
+    // Applies the deletions, then the insertions. Deleting an edge that is
+    // not present is ignored; with parallel edges one copy is removed.
+    IncrementalStats applyBatch(const EdgeBatch &batch) {
+        IncrementalStats stats;
+
+        std::vector<int> cut;
+        for (const std::pair<int, int> &e : batch.deletions)
+        {
+            int u = e.first, v = e.second;
+            if (!eraseOne(out[u], v))
+                continue;
+            eraseOne(in[v], u);
+            if (par[v] == u && std::find(out[u].begin(), out[u].end(), v) == out[u].end())
+                cut.push_back(v);
+        }
+        if (!cut.empty())
+            repair(cut, stats);
+
+        for (const std::pair<int, int> &e : batch.insertions)
+        {
+            int u = e.first, v = e.second;
+            out[u].push_back(v);
+            in[v].push_back(u);
+            if (lab[u] < lab[v])
+                lower(v, u, stats);
+        }
+        return stats;
+    }
+
+private:
+    static bool eraseOne(std::vector<int> &list, int v) {
+        auto it = std::find(list.begin(), list.end(), v);
+        if (it == list.end())
+            return false;
+        *it = list.back();
+        list.pop_back();
+        return true;
+    }
+
+    // Gives v the label of from, and everything reachable from v whose label
+    // is higher.
+    void lower(int v, int from, IncrementalStats &stats) {
+        setLabel(v, lab[from], from, stats);
+        queue.assign(1, v);
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            int x = queue[head];
+            for (int y : out[x])
+            {
+                if (lab[x] < lab[y])
+                {
+                    setLabel(y, lab[x], x, stats);
+                    queue.push_back(y);
+                }
+            }
+        }
+    }
+
+    void setLabel(int v, int label, int parent, IncrementalStats &stats) {
+        if (lab[v] == v)
+            roots--;
+        lab[v] = label;
+        par[v] = parent;
+        stats.labelChanges++;
+    }
+
+    // Relabels the support subtrees under the cut vertices.
+    void repair(const std::vector<int> &cut, IncrementalStats &stats) {
+        // Collect the subtrees: children of x are out-neighbors with parent x.
+        queue.clear();
+        for (int v : cut)
+        {
+            if (inRepair[v])
+                continue;
+            inRepair[v] = 1;
+            queue.push_back(v);
+        }
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            int x = queue[head];
+            for (int y : out[x])
+            {
+                if (par[y] == x && !inRepair[y])
+                {
+                    inRepair[y] = 1;
+                    queue.push_back(y);
+                }
+            }
+        }
+        std::vector<int> subtree;
+        subtree.swap(queue);
+        stats.repairedVertices += subtree.size();
+
+        // Best label each vertex can take directly: its own ID, or the label
+        // of an in-neighbor outside the subtree.
+        struct Seed {
+            int label;
+            int vertex;
+            int parent;
+        };
+        std::vector<Seed> seeds;
+        std::vector<int> oldLabel;
+        seeds.reserve(subtree.size());
+        oldLabel.reserve(subtree.size());
+        for (int x : subtree)
+        {
+            oldLabel.push_back(lab[x]);
+            if (lab[x] == x)
+                roots--;
+            Seed seed = {x, x, -1};
+            for (int p : in[x])
+            {
+                if (!inRepair[p] && lab[p] < seed.label)
+                {
+                    seed.label = lab[p];
+                    seed.parent = p;
+                }
+            }
+            seeds.push_back(seed);
+        }
+        std::sort(seeds.begin(), seeds.end(), [](const Seed &a, const Seed &b) { return a.label < b.label; });
+
+        // Smallest labels first: a vertex keeps the first label that reaches it.
+        for (const Seed &seed : seeds)
+        {
+            if (!inRepair[seed.vertex])
+                continue;
+            inRepair[seed.vertex] = 0;
+            lab[seed.vertex] = seed.label;
+            par[seed.vertex] = seed.parent;
+            queue.assign(1, seed.vertex);
+            for (size_t head = 0; head < queue.size(); head++)
+            {
+                int x = queue[head];
+                for (int y : out[x])
+                {
+                    if (inRepair[y])
+                    {
+                        inRepair[y] = 0;
+                        lab[y] = seed.label;
+                        par[y] = x;
+                        queue.push_back(y);
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < subtree.size(); i++)
+        {
+            int x = subtree[i];
+            if (lab[x] == x)
+                roots++;
+            if (lab[x] != oldLabel[i])
+                stats.labelChanges++;
+        }
+    }
+
+    std::vector<std::vector<int>> out;
+    std::vector<std::vector<int>> in;
+    std::vector<int> lab;
+    std::vector<int> par;
+    int roots = 0;
+
+    // Scratch
+    std::vector<char> inRepair;
+    std::vector<int> queue;
+};
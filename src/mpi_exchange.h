@@ -0,0 +1,283 @@
+#pragma once
+
+#include <mpi.h>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+// Boundary exchange layer for the MPI engine.
+//
+// Every rank hands over one buffer of vertex IDs per destination rank and
+// gets back everything addressed to it as one flat array. The exchange runs
+// in two steps, counts and then data, and the count step is non-blocking
+// so it can overlap local traversal. Three implementations can be swapped
+// for benchmarking:
+//
+//   PointToPoint       one size message to every other rank, plus a data
+//                      message to each rank with a non-empty buffer
+//   Alltoallv          MPI_Ialltoall for counts, MPI_Alltoallv for data
+//   NeighborAlltoallv  MPI_Ineighbor_alltoall / MPI_Neighbor_alltoallv on a
+//                      distributed graph topology holding only the ranks
+//                      that actually share cut edges
+
+enum class ExchangeMode { PointToPoint, Alltoallv, NeighborAlltoallv };
+
+inline const char *exchangeModeName(ExchangeMode mode) {
+    switch (mode)
+    {
+    case ExchangeMode::PointToPoint: return "p2p";
+    case ExchangeMode::Alltoallv: return "alltoallv";
+    case ExchangeMode::NeighborAlltoallv: return "neighbor";
+    }
+    return "unknown";
+}
+
+inline bool parseExchangeMode(const char *name, ExchangeMode &mode) {
+    for (ExchangeMode m : {ExchangeMode::PointToPoint, ExchangeMode::Alltoallv, ExchangeMode::NeighborAlltoallv})
+    {
+        if (strcmp(name, exchangeModeName(m)) == 0)
+        {
+            mode = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+class BoundaryExchange {
+public:
+    // destRanks lists every rank this rank may ever send to. It is only used
+    // to build the neighborhood topology; collective over comm.
+    BoundaryExchange(MPI_Comm comm, ExchangeMode mode, const std::vector<int> &destRanks)
+        : comm(comm), mode(mode) {
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &numRanks);
+
+        if (mode == ExchangeMode::NeighborAlltoallv)
+        {
+            // One-time flag exchange tells every rank who sends to it.
+            std::vector<int> sendsTo(numRanks, 0), receivesFrom(numRanks, 0);
+            for (int r : destRanks)
+                if (r != rank)
+                    sendsTo[r] = 1;
+            MPI_Alltoall(sendsTo.data(), 1, MPI_INT, receivesFrom.data(), 1, MPI_INT, comm);
+
+            for (int r = 0; r < numRanks; r++)
+            {
+                if (sendsTo[r])
+                    destinations.push_back(r);
+                if (receivesFrom[r])
+                    sources.push_back(r);
+            }
+            MPI_Dist_graph_create_adjacent(comm, sources.size(), sources.data(), MPI_UNWEIGHTED,
+                                           destinations.size(), destinations.data(), MPI_UNWEIGHTED,
+                                           MPI_INFO_NULL, 0, &neighborComm);
+        }
+        else
+        {
+            for (int r = 0; r < numRanks; r++)
+            {
+                if (r != rank)
+                {
+                    destinations.push_back(r);
+                    sources.push_back(r);
+                }
+            }
+        }
+    }
+
+    ~BoundaryExchange() {
+        if (neighborComm != MPI_COMM_NULL)
+            MPI_Comm_free(&neighborComm);
+    }
+
+    BoundaryExchange(const BoundaryExchange &) = delete;
+    BoundaryExchange &operator=(const BoundaryExchange &) = delete;
+
+    ExchangeMode exchangeMode() const { return mode; }
+    int numSources() const { return sources.size(); }
+    int numDestinations() const { return destinations.size(); }
+
+    // Posts the count exchange (and, for PointToPoint, the data sends).
+    // sendBuffers is indexed by rank and must stay untouched until finish().
+    void start(const std::vector<std::vector<int>> &sendBuffers) {
+        int numSend = destinations.size();
+        int numRecv = sources.size();
+        sendCounts.assign(numSend, 0);
+        recvCounts.assign(numRecv, 0);
+        sendRequests.clear();
+        countRequests.clear();
+
+        for (int k = 0; k < numSend; k++)
+            sendCounts[k] = sendBuffers[destinations[k]].size();
+
+        switch (mode)
+        {
+        case ExchangeMode::PointToPoint:
+            for (int k = 0; k < numRecv; k++)
+            {
+                MPI_Request req;
+                MPI_Irecv(&recvCounts[k], 1, MPI_INT, sources[k], 0, comm, &req);
+                countRequests.push_back(req);
+            }
+            for (int k = 0; k < numSend; k++)
+            {
+                MPI_Request req;
+                MPI_Isend(&sendCounts[k], 1, MPI_INT, destinations[k], 0, comm, &req);
+                sendRequests.push_back(req);
+
+                if (sendCounts[k] > 0)
+                {
+                    MPI_Isend(sendBuffers[destinations[k]].data(), sendCounts[k], MPI_INT,
+                              destinations[k], 1, comm, &req);
+                    sendRequests.push_back(req);
+                }
+            }
+            break;
+
+        case ExchangeMode::Alltoallv:
+        {
+            // Collectives want full-size arrays indexed by rank.
+            fullSendCounts.assign(numRanks, 0);
+            fullRecvCounts.assign(numRanks, 0);
+            for (int k = 0; k < numSend; k++)
+                fullSendCounts[destinations[k]] = sendCounts[k];
+            MPI_Request req;
+            MPI_Ialltoall(fullSendCounts.data(), 1, MPI_INT, fullRecvCounts.data(), 1, MPI_INT, comm, &req);
+            countRequests.push_back(req);
+            break;
+        }
+
+        case ExchangeMode::NeighborAlltoallv:
+        {
+            MPI_Request req;
+            MPI_Ineighbor_alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT,
+                                   neighborComm, &req);
+            countRequests.push_back(req);
+            break;
+        }
+        }
+
+        this->sendBuffers = &sendBuffers;
+    }
+
+    // Progresses the count exchange without blocking.
+    bool countsArrived() {
+        if (countRequests.empty())
+            return true;
+        int flag = 0;
+        MPI_Testall(countRequests.size(), countRequests.data(), &flag, MPI_STATUSES_IGNORE);
+        if (flag)
+            countRequests.clear();
+        return flag != 0;
+    }
+
+    // Blocks for the counts and sizes `received` to hold all incoming data,
+    // laid out by source in ascending rank order.
+    void waitCounts(std::vector<int> &received) {
+        if (!countRequests.empty())
+            MPI_Waitall(countRequests.size(), countRequests.data(), MPI_STATUSES_IGNORE);
+        countRequests.clear();
+
+        if (mode == ExchangeMode::Alltoallv)
+            for (size_t k = 0; k < sources.size(); k++)
+                recvCounts[k] = fullRecvCounts[sources[k]];
+
+        recvDispls.assign(sources.size() + 1, 0);
+        for (size_t k = 0; k < sources.size(); k++)
+            recvDispls[k + 1] = recvDispls[k] + recvCounts[k];
+        received.resize(recvDispls.back());
+    }
+
+    // True when receiveFrom may be called concurrently for different sources
+    // (given MPI_THREAD_MULTIPLE).
+    bool perSourceReceive() const { return mode == ExchangeMode::PointToPoint; }
+
+    // PointToPoint only: receives source k's data into its slice of `received`.
+    void receiveFrom(int k, std::vector<int> &received) {
+        if (recvCounts[k] > 0)
+            MPI_Recv(received.data() + recvDispls[k], recvCounts[k], MPI_INT, sources[k], 1,
+                     comm, MPI_STATUS_IGNORE);
+    }
+
+    // Receives all data into `received` (sized by waitCounts).
+    void receiveAll(std::vector<int> &received) {
+        switch (mode)
+        {
+        case ExchangeMode::PointToPoint:
+        {
+            std::vector<MPI_Request> requests;
+            for (size_t k = 0; k < sources.size(); k++)
+            {
+                if (recvCounts[k] > 0)
+                {
+                    MPI_Request req;
+                    MPI_Irecv(received.data() + recvDispls[k], recvCounts[k], MPI_INT, sources[k], 1,
+                              comm, &req);
+                    requests.push_back(req);
+                }
+            }
+            if (!requests.empty())
+                MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+            break;
+        }
+
+        case ExchangeMode::Alltoallv:
+        {
+            packSendData();
+            std::vector<int> sdispls(numRanks, 0), rdispls(numRanks, 0);
+            for (size_t k = 0; k < destinations.size(); k++)
+                sdispls[destinations[k]] = sendDispls[k];
+            for (size_t k = 0; k < sources.size(); k++)
+                rdispls[sources[k]] = recvDispls[k];
+            MPI_Alltoallv(packed.data(), fullSendCounts.data(), sdispls.data(), MPI_INT,
+                          received.data(), fullRecvCounts.data(), rdispls.data(), MPI_INT, comm);
+            break;
+        }
+
+        case ExchangeMode::NeighborAlltoallv:
+            packSendData();
+            MPI_Neighbor_alltoallv(packed.data(), sendCounts.data(), sendDispls.data(), MPI_INT,
+                                   received.data(), recvCounts.data(), recvDispls.data(), MPI_INT,
+                                   neighborComm);
+            break;
+        }
+    }
+
+    // Completes outstanding sends; sendBuffers may be reused afterwards.
+    void finish() {
+        if (!sendRequests.empty())
+            MPI_Waitall(sendRequests.size(), sendRequests.data(), MPI_STATUSES_IGNORE);
+        sendRequests.clear();
+        sendBuffers = nullptr;
+    }
+
+private:
+    void packSendData() {
+        sendDispls.assign(destinations.size() + 1, 0);
+        for (size_t k = 0; k < destinations.size(); k++)
+            sendDispls[k + 1] = sendDispls[k] + sendCounts[k];
+
+        packed.resize(sendDispls.back());
+        for (size_t k = 0; k < destinations.size(); k++)
+        {
+            const std::vector<int> &buffer = (*sendBuffers)[destinations[k]];
+            std::copy(buffer.begin(), buffer.end(), packed.begin() + sendDispls[k]);
+        }
+    }
+
+    MPI_Comm comm;
+    MPI_Comm neighborComm = MPI_COMM_NULL;
+    ExchangeMode mode;
+    int rank = 0;
+    int numRanks = 1;
+
+    std::vector<int> destinations;  // ranks we send to, ascending
+    std::vector<int> sources;       // ranks we receive from, ascending
+    std::vector<int> sendCounts, recvCounts;         // indexed like destinations / sources
+    std::vector<int> fullSendCounts, fullRecvCounts; // indexed by rank (Alltoallv)
+    std::vector<int> sendDispls, recvDispls;
+    std::vector<int> packed;
+    std::vector<MPI_Request> countRequests, sendRequests;
+    const std::vector<std::vector<int>> *sendBuffers = nullptr;
+};
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <omp.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "csr_graph.h"
+#include "affinity.h"
+#include "dfs_engine.h"
+
+// NUMA-aware placement and work stealing for the parallel engine.
+//
+// Topology comes from /sys/devices/system/node, pinning uses
+// sched_setaffinity, and page policy and placement queries go through the
+// mbind and move_pages system calls directly, so nothing links against
+// libnuma. On a machine without NUMA information everything collapses to
+// one node holding every CPU the process may run on.
+//
+// Nodes are numbered twice: the kernel's node ids, which the system calls
+// and page queries use and which need not be contiguous, and a compact index
+// over the nodes we run on, which only groups threads for stealing.
+//
+// NumaCSRGraph allocates its arrays untouched and either lets each pinned
+// thread fault in the vertex range it will traverse (first touch) or asks
+// the kernel to interleave the pages over the nodes we run on. dfsParallelNuma starts
+// each thread on its own vertex range and, when a thread runs dry, steals
+// from threads on its own node before crossing to another socket.
+
+struct NumaTopology {
+    // Indexed by compact node index; only nodes with CPUs we may use.
+    std::vector<std::vector<int>> nodeCpus; // CPUs of the node
+    std::vector<int> nodeIds;               // kernel node id
+    std::vector<int> memoryNodeIds;         // kernel ids of those nodes whose memory we may use
+
+    int numNodes() const { return nodeCpus.size(); }
+    bool isSingleNode() const { return nodeCpus.size() <= 1; }
+
+    static NumaTopology detect() {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+
+        // Online node ids may have gaps, e.g. "0,2"
+        NumaTopology topology;
+        std::vector<int> allowedMems = readList("/proc/self/status", "Mems_allowed_list:");
+        for (int node : readList("/sys/devices/system/node/online", ""))
+        {
+            std::vector<int> cpus;
+            for (int cpu : readList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", ""))
+                if (CPU_ISSET(cpu, &allowed))
+                    cpus.push_back(cpu);
+            if (cpus.empty())
+                continue;
+            topology.nodeCpus.push_back(cpus);
+            topology.nodeIds.push_back(node);
+            if (allowedMems.empty() || std::count(allowedMems.begin(), allowedMems.end(), node))
+                topology.memoryNodeIds.push_back(node);
+        }
+
+        // Without NUMA information the kernel puts everything on node 0
+        if (topology.nodeCpus.empty())
+        {
+            std::vector<int> cpus;
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                if (CPU_ISSET(cpu, &allowed))
+                    cpus.push_back(cpu);
+            topology.nodeCpus.push_back(cpus);
+            topology.nodeIds.push_back(0);
+            topology.memoryNodeIds.push_back(0);
+        }
+        return topology;
+    }
+
+    // The list on the line of path that starts with prefix (the first line
+    // if prefix is empty); empty if there is none.
+    static std::vector<int> readList(const std::string &path, const std::string &prefix) {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+            if (line.compare(0, prefix.size(), prefix) == 0)
+                return parseCpuList(line.substr(prefix.size()));
+        return std::vector<int>();
+    }
+
+    // Parses "0-3,8,10-11"; node lists use the same format.
+    static std::vector<int> parseCpuList(const std::string &list) {
+        std::vector<int> cpus;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ','))
+        {
+            range.erase(0, range.find_first_not_of(" \t"));
+            if (range.empty())
+                continue;
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+};
+
+// Where each OpenMP thread runs: threads are split evenly across nodes in
+// contiguous groups, so thread IDs that are close share a socket.
+struct ThreadPlacement {
+    std::vector<int> cpu;
+    std::vector<int> node;   // compact node index, for steal order
+    std::vector<int> nodeId; // kernel node id, for page placement
+
+    ThreadPlacement(const NumaTopology &topology, int numThreads)
+        : cpu(numThreads), node(numThreads), nodeId(numThreads) {
+        int numNodes = topology.numNodes();
+        for (int t = 0; t < numThreads; t++)
+        {
+            int nd = (long long)t * numNodes / numThreads;
+            int firstOnNode = (nd * numThreads + numNodes - 1) / numNodes;
+            const std::vector<int> &cpus = topology.nodeCpus[nd];
+            node[t] = nd;
+            nodeId[t] = topology.nodeIds[nd];
+            cpu[t] = cpus[(t - firstOnNode) % cpus.size()];
+        }
+    }
+};
+
+// Page-aligned array whose pages are not touched on allocation, so that
+// placement is decided by whoever writes them first (or by interleave()).
+// Throws std::bad_alloc if the mapping fails.
+template <typename T>
+class NumaArray {
+public:
+    NumaArray() = default;
+    explicit NumaArray(size_t count) : count(count) {
+        bytes = std::max<size_t>(count * sizeof(T), 1);
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        ptr = (T *)p;
+    }
+    ~NumaArray() {
+        if (ptr)
+            munmap(ptr, bytes);
+    }
+
+    NumaArray(NumaArray &&other) noexcept { swap(other); }
+    NumaArray &operator=(NumaArray &&other) noexcept {
+        swap(other);
+        return *this;
+    }
+    NumaArray(const NumaArray &) = delete;
+    NumaArray &operator=(const NumaArray &) = delete;
+
+    T *data() { return ptr; }
+    const T *data() const { return ptr; }
+    size_t size() const { return count; }
+    size_t sizeBytes() const { return bytes; }
+    T &operator[](size_t i) { return ptr[i]; }
+    const T &operator[](size_t i) const { return ptr[i]; }
+
+    // Sets an interleave policy over the given kernel node ids before any
+    // page is touched. Returns false if mbind is unavailable.
+    bool interleave(const std::vector<int> &nodeIds) {
+        const int MPOL_INTERLEAVE_MODE = 3;
+        const int bitsPerWord = 8 * sizeof(unsigned long);
+        int maxNode = nodeIds.empty() ? 0 : *std::max_element(nodeIds.begin(), nodeIds.end());
+        std::vector<unsigned long> nodeMask(maxNode / bitsPerWord + 1, 0);
+        for (int node : nodeIds)
+            nodeMask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+        return syscall(SYS_mbind, ptr, bytes, MPOL_INTERLEAVE_MODE, nodeMask.data(),
+                       nodeMask.size() * bitsPerWord + 1, 0) == 0;
+    }
+
+private:
+    void swap(NumaArray &other) {
+        std::swap(ptr, other.ptr);
+        std::swap(count, other.count);
+        std::swap(bytes, other.bytes);
+    }
+
+    T *ptr = nullptr;
+    size_t count = 0;
+    size_t bytes = 0;
+};
+
+// NUMA node of every page in [ptr, ptr + bytes), -1 for pages not yet
+// faulted in or when move_pages is unavailable.
+inline std::vector<int> pageNodes(const void *ptr, size_t bytes) {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t first = (uintptr_t)ptr & ~(uintptr_t)(pageSize - 1);
+    size_t numPages = ((uintptr_t)ptr + bytes - first + pageSize - 1) / pageSize;
+
+    std::vector<void *> pages(numPages);
+    for (size_t p = 0; p < numPages; p++)
+        pages[p] = (void *)(first + p * pageSize);
+    std::vector<int> status(numPages, -1);
+    if (syscall(SYS_move_pages, 0, numPages, pages.data(), nullptr, status.data(), 0) != 0)
+        std::fill(status.begin(), status.end(), -1);
+    for (int &s : status)
+        if (s < 0)
+            s = -1;
+    return status;
+}
+
+enum class NumaPolicy { FirstTouch, Interleave };
+
+// CSR graph whose arrays are placed for a given thread placement. Vertex
+// range t (see rangeBegin) is traversed first by thread t, so under
+// FirstTouch its offsets, neighbors and visited flags live on t's node.
+class NumaCSRGraph {
+public:
+    NumaCSRGraph(const CSRGraph &graph, const ThreadPlacement &placement, const NumaTopology &topology,
+                 NumaPolicy policy)
+        : n(graph.size()), offsets(graph.size() + 1), neighbors(graph.numEdges()) {
+        int numThreads = placement.cpu.size();
+        rangeStart.resize(numThreads + 1);
+        for (int t = 0; t <= numThreads; t++)
+            rangeStart[t] = (long long)n * t / numThreads;
+
+        if (policy == NumaPolicy::Interleave && topology.memoryNodeIds.size() > 1)
+        {
+            offsets.interleave(topology.memoryNodeIds);
+            neighbors.interleave(topology.memoryNodeIds);
+        }
+
+        #pragma omp parallel num_threads(numThreads)
+        {
+            AffinityGuard guard;
+            int t = omp_get_thread_num();
+            pinThreadToCpu(placement.cpu[t]);
+            for (int v = rangeStart[t]; v < rangeStart[t + 1]; v++)
+                offsets[v] = graph.offsets[v];
+            if (t == numThreads - 1)
+                offsets[n] = graph.offsets[n];
+            std::copy(graph.neighbors.begin() + graph.offsets[rangeStart[t]],
+                      graph.neighbors.begin() + graph.offsets[rangeStart[t + 1]],
+                      neighbors.data() + graph.offsets[rangeStart[t]]);
+        }
+    }
+
+    int size() const { return n; }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    const int *begin(int v) const { return neighbors.data() + offsets[v]; }
+    const int *end(int v) const { return neighbors.data() + offsets[v + 1]; }
+    void prefetchIndex(int v) const { __builtin_prefetch(&offsets[v]); }
+    int rangeBegin(int t) const { return rangeStart[t]; }
+    int rangeEnd(int t) const { return rangeStart[t + 1]; }
+
+    const NumaArray<int64_t> &offsetArray() const { return offsets; }
+    const NumaArray<int> &neighborArray() const { return neighbors; }
+
+private:
+    int n;
+    NumaArray<int64_t> offsets;
+    NumaArray<int> neighbors;
+    std::vector<int> rangeStart;
+};
+
+// Page counts per node and how many pages sit on a node other than the one
+// of the thread that traverses them. Pages whose node is unknown are left
+// out; remoteRatio() is -1 if no page could be queried.
+struct PlacementReport {
+    std::vector<long long> pagesPerNode;
+    long long localPages = 0;
+    long long remotePages = 0;
+
+    double remoteRatio() const {
+        long long known = localPages + remotePages;
+        return known == 0 ? -1 : (double)remotePages / known;
+    }
+};
+
+// ownerNode is a kernel node id, as move_pages reports.
+inline void addPlacement(PlacementReport &report, const void *ptr, size_t bytes, int ownerNode) {
+    if (bytes == 0)
+        return;
+    for (int node : pageNodes(ptr, bytes))
+    {
+        if (node < 0)
+            continue;
+        if ((int)report.pagesPerNode.size() <= node)
+            report.pagesPerNode.resize(node + 1, 0);
+        report.pagesPerNode[node]++;
+        if (node == ownerNode)
+            report.localPages++;
+        else
+            report.remotePages++;
+    }
+}
+
+// Placement of the neighbor array relative to the threads that traverse it.
+inline PlacementReport placementReport(const NumaCSRGraph &graph, const ThreadPlacement &placement) {
+    PlacementReport report;
+    for (size_t t = 0; t < placement.cpu.size(); t++)
+    {
+        const int *first = graph.begin(graph.rangeBegin(t));
+        const int *last = graph.begin(graph.rangeEnd(t));
+        addPlacement(report, first, (last - first) * sizeof(int), placement.nodeId[t]);
+    }
+    return report;
+}
+
+// Parallel DFS with pinned threads and socket-aware work stealing: the
+// engine's WorkStealing policy, run on the placement's CPUs after each
+// thread has faulted in its slice of the visited array. visitor sees every
+// vertex once, from the thread that visited it.
+template <typename Visitor>
+inline void dfsParallelNumaWith(const NumaCSRGraph &graph, const ThreadPlacement &placement, Visitor &visitor,
+                                StealStats &stats, DfsOptions options = DfsOptions()) {
+    int n = graph.size();
+    int numThreads = placement.cpu.size();
+    NumaArray<char> visited(paddedFlagCount(n));
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        AffinityGuard guard;
+        int t = omp_get_thread_num();
+        pinThreadToCpu(placement.cpu[t]);
+        memset(visited.data() + graph.rangeBegin(t), 0, graph.rangeEnd(t) - graph.rangeBegin(t));
+    }
+
+    WorkStealing policy;
+    policy.numThreads = numThreads;
+    policy.threadNode = placement.node;
+    policy.threadCpu = placement.cpu;
+    policy.stats = &stats;
+    AtomicVisited claims(visited.data());
+    dfsRunWith(policy, graph, claims, visitor, options);
+}
+
+// dfsParallelNumaWith collecting the order. Each thread records its visits
+// in its own buffer, so those pages are local too. Returns every vertex
+// once, grouped by the thread that visited it.
+inline std::vector<int> dfsParallelNuma(const NumaCSRGraph &graph, const ThreadPlacement &placement,
+                                        StealStats &stats, DfsOptions options = DfsOptions(),
+                                        bool simulateWork = false) {
+    OrderCollector visitor(simulateWork);
+    dfsParallelNumaWith(graph, placement, visitor, stats, options);
+
+    std::vector<int> res;
+    res.reserve(graph.size());
+    visitor.appendOrder(res);
+    return res;
+}
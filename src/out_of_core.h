@@ -0,0 +1,530 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "csr_graph.h"
+#include "dfs_engine.h"
+
+// Out-of-core DFS for graphs whose adjacency does not fit in memory.
+//
+// The graph is stored on disk as CSR: a header, the n + 1 edge offsets and
+// the concatenated neighbor lists. Only the offsets and a visited bitmap
+// stay in memory; neighbor lists are read in fixed-size blocks through a
+// bounded BlockCache with clock replacement. A read-ahead thread loads
+// the block the traversal will turn to next with pread while the current
+// one is processed (io_uring is not assumed to be present).
+//
+// dfsOutOfCore runs the shared engine loop (dfs_engine.h) with a bitmap of
+// visited vertices and groups the frontier by block: a neighbor whose block
+// is not resident is parked on that block's pending list instead of being
+// pushed, and when the stack runs dry the block with the most parked
+// vertices is loaded next. The visit order is therefore a depth-first order
+// within each block visit rather than one global DFS order; every vertex is
+// still visited exactly once.
+//
+// open() rejects a file whose size or offsets disagree with its header, and
+// every block is checked for neighbor IDs outside [0, numVertices) when it
+// is read. A failed or short read is not cached: pin() returns null and
+// dfsOutOfCore returns false.
+
+struct GraphFileHeader {
+    char magic[8];
+    int64_t numVertices;
+    int64_t numEdges;
+};
+
+// Writes adj in the on-disk CSR format. Returns false on I/O failure.
+inline bool writeGraphFile(const std::string &path, const std::vector<std::vector<int>> &adj) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    GraphFileHeader header = {{'D', 'F', 'S', 'G', 'R', 'A', 'P', 'H'}, (int64_t)adj.size(), 0};
+    std::vector<int64_t> offsets(adj.size() + 1, 0);
+    for (size_t s = 0; s < adj.size(); s++)
+        offsets[s + 1] = offsets[s] + adj[s].size();
+    header.numEdges = offsets.back();
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(offsets.data(), sizeof(int64_t), offsets.size(), file) == offsets.size();
+    for (size_t s = 0; ok && s < adj.size(); s++)
+        ok = fwrite(adj[s].data(), sizeof(int), adj[s].size(), file) == adj[s].size();
+
+    return fclose(file) == 0 && ok;
+}
+
+// Loads a file written by writeGraphFile entirely into memory. Returns false
+// on I/O failure or a malformed file: offsets that do not start at 0, run
+// backwards or miss the edge count, or a neighbor that is not a vertex.
+inline bool readGraphFile(const std::string &path, CSRGraph &graph) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    GraphFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && std::string(header.magic, 8) == "DFSGRAPH" &&
+              header.numVertices >= 0 && header.numEdges >= 0 && header.numVertices < INT32_MAX;
+    if (ok)
+    {
+        graph.offsets.resize(header.numVertices + 1);
+        ok = fread(graph.offsets.data(), sizeof(int64_t), graph.offsets.size(), file) == graph.offsets.size() &&
+             graph.offsets[0] == 0 && graph.offsets.back() == header.numEdges;
+        for (int64_t v = 0; ok && v < header.numVertices; v++)
+            ok = graph.offsets[v] <= graph.offsets[v + 1];
+    }
+    if (ok)
+    {
+        graph.neighbors.resize(header.numEdges);
+        ok = fread(graph.neighbors.data(), sizeof(int), graph.neighbors.size(), file) == graph.neighbors.size();
+        for (size_t e = 0; ok && e < graph.neighbors.size(); e++)
+            ok = graph.neighbors[e] >= 0 && graph.neighbors[e] < header.numVertices;
+    }
+    fclose(file);
+    return ok;
+}
+
+class BlockCache {
+public:
+    // Serves blocks of blockInts ints from fd, starting at byte dataOffset.
+    // Every int must lie in [0, valueLimit).
+    BlockCache(int fd, off_t dataOffset, int64_t numInts, int valueLimit, int blockInts, int capacity,
+               bool readAhead)
+        : fd(fd), dataOffset(dataOffset), numInts(numInts), valueLimit(valueLimit), blockInts(blockInts),
+          slots(std::max(capacity, 2)) {
+        numBlocks = (numInts + blockInts - 1) / blockInts;
+        slotOf.assign(numBlocks, -1);
+        for (Slot &slot : slots)
+            slot.data.resize(blockInts);
+        if (readAhead)
+            worker = std::thread(&BlockCache::readAheadLoop, this);
+    }
+
+    ~BlockCache() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    BlockCache(const BlockCache &) = delete;
+    BlockCache &operator=(const BlockCache &) = delete;
+
+    int64_t blockCount() const { return numBlocks; }
+    int blockSize() const { return blockInts; }
+
+    bool resident(int64_t block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int s = slotOf[block];
+        return s >= 0 && !slots[s].loading;
+    }
+
+    // Returns the block's data, loading it synchronously if needed. The block
+    // stays resident until the matching unpin(). Returns null, with nothing
+    // pinned, if the block cannot be read.
+    const int *pin(int64_t block) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            int s = slotOf[block];
+            if (s >= 0)
+            {
+                if (slots[s].loading)
+                {
+                    changed.wait(lock);
+                    continue;
+                }
+                slots[s].pins++;
+                slots[s].referenced = true;
+                hits++;
+                return slots[s].data.data();
+            }
+
+            s = evictSlot();
+            if (s < 0)
+            {
+                changed.wait(lock);
+                continue;
+            }
+            misses++;
+            if (!loadInto(s, block, lock))
+                return nullptr;
+            slots[s].pins++;
+            return slots[s].data.data();
+        }
+    }
+
+    void unpin(int64_t block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slots[slotOf[block]].pins--;
+    }
+
+    // Asks the read-ahead thread to load a block; ignored when it is resident
+    // or already queued.
+    void prefetch(int64_t block) {
+        if (!worker.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (slotOf[block] >= 0 || std::find(queue.begin(), queue.end(), block) != queue.end())
+                return;
+            queue.push_back(block);
+        }
+        changed.notify_all();
+    }
+
+    int64_t cacheHits() const { return hits; }
+    int64_t cacheMisses() const { return misses; }
+    int64_t blocksRead() const { return reads; }
+    int64_t readErrors() const { return errors; }
+
+private:
+    struct Slot {
+        int64_t block = -1;
+        int pins = 0;
+        bool referenced = false;
+        bool loading = false;
+        std::vector<int> data;
+    };
+
+    // Clock sweep over unpinned slots; -1 if every slot is pinned or loading.
+    int evictSlot() {
+        for (size_t step = 0; step < 2 * slots.size(); step++)
+        {
+            Slot &slot = slots[hand];
+            int s = hand;
+            hand = (hand + 1) % slots.size();
+            if (slot.pins > 0 || slot.loading)
+                continue;
+            if (slot.referenced)
+            {
+                slot.referenced = false;
+                continue;
+            }
+            if (slot.block >= 0)
+                slotOf[slot.block] = -1;
+            slot.block = -1;
+            return s;
+        }
+        return -1;
+    }
+
+    // Reads a block into slot s with the lock released during the pread. On
+    // a failed or short read, or an out-of-range value, the slot is left
+    // empty and false is returned.
+    bool loadInto(int s, int64_t block, std::unique_lock<std::mutex> &lock) {
+        Slot &slot = slots[s];
+        slot.block = block;
+        slot.loading = true;
+        slot.referenced = true;
+        slotOf[block] = s;
+
+        int64_t first = block * blockInts;
+        int64_t count = std::min<int64_t>(blockInts, numInts - first);
+        int *dest = slot.data.data();
+        lock.unlock();
+
+        size_t want = count * sizeof(int);
+        size_t done = 0;
+        while (done < want)
+        {
+            ssize_t got = pread(fd, (char *)dest + done, want - done, dataOffset + first * sizeof(int) + done);
+            if (got <= 0)
+                break;
+            done += got;
+        }
+        bool ok = done == want;
+        for (int64_t k = 0; ok && k < count; k++)
+            ok = dest[k] >= 0 && dest[k] < valueLimit;
+
+        lock.lock();
+        reads++;
+        slot.loading = false;
+        if (!ok)
+        {
+            errors++;
+            slot.block = -1;
+            slot.referenced = false;
+            slotOf[block] = -1;
+        }
+        changed.notify_all();
+        return ok;
+    }
+
+    void readAheadLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            changed.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping)
+                return;
+
+            int64_t block = queue.front();
+            queue.pop_front();
+            if (slotOf[block] >= 0)
+                continue;
+
+            int s = evictSlot();
+            if (s < 0)
+                continue; // cache full of pinned blocks; drop the hint
+            loadInto(s, block, lock);
+        }
+    }
+
+    int fd;
+    off_t dataOffset;
+    int64_t numInts;
+    int valueLimit;
+    int blockInts;
+    int64_t numBlocks = 0;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<Slot> slots;
+    std::vector<int> slotOf; // block -> slot, -1 when not resident
+    size_t hand = 0;
+    std::deque<int64_t> queue;
+    bool stopping = false;
+    std::thread worker;
+
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t reads = 0;
+    int64_t errors = 0;
+};
+
+class OutOfCoreGraph {
+public:
+    ~OutOfCoreGraph() {
+        cache.reset();
+        if (fd >= 0)
+            close(fd);
+    }
+
+    // Opens a file written by writeGraphFile with a cache of cacheBlocks
+    // blocks of blockInts neighbors each. Returns false on failure or when
+    // the file size or offsets do not match the header.
+    bool open(const std::string &path, int blockInts, int cacheBlocks, bool readAhead = true) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        GraphFileHeader header;
+        struct stat info;
+        if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            std::string(header.magic, 8) != "DFSGRAPH" || header.numVertices < 0 || header.numEdges < 0 ||
+            header.numVertices >= INT32_MAX || fstat(fd, &info) != 0)
+            return false;
+
+        size_t bytes = (header.numVertices + 1) * sizeof(int64_t);
+        if (info.st_size != (off_t)(sizeof(header) + bytes + header.numEdges * sizeof(int)))
+            return false;
+        offsets.resize(header.numVertices + 1);
+        if (pread(fd, offsets.data(), bytes, sizeof(header)) != (ssize_t)bytes)
+            return false;
+        if (offsets[0] != 0 || offsets.back() != header.numEdges)
+            return false;
+        for (int64_t v = 0; v < header.numVertices; v++)
+            if (offsets[v] > offsets[v + 1])
+                return false;
+
+#ifdef POSIX_FADV_RANDOM
+        // The cache decides what to read; kernel read-ahead would only waste bandwidth.
+        posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+#endif
+        cache.reset(new BlockCache(fd, sizeof(header) + bytes, header.numEdges, header.numVertices, blockInts,
+                                   cacheBlocks, readAhead));
+        return true;
+    }
+
+    int numVertices() const { return offsets.size() - 1; }
+    int64_t firstBlock(int v) const { return offsets[v] / cache->blockSize(); }
+    BlockCache &blocks() { return *cache; }
+
+    // Calls f(u) for each neighbor of v, pinning each block it spans.
+    // Returns false, and sets readFailed(), if a block cannot be read.
+    template <typename F>
+    bool forEachNeighbor(int v, F f) const {
+        int64_t begin = offsets[v];
+        int64_t end = offsets[v + 1];
+        int blockInts = cache->blockSize();
+
+        while (begin < end)
+        {
+            int64_t block = begin / blockInts;
+            int64_t blockEnd = std::min(end, (block + 1) * blockInts);
+            const int *data = cache->pin(block);
+            if (!data)
+            {
+                failed = true;
+                return false;
+            }
+            for (int64_t i = begin; i < blockEnd; i++)
+                f(data[i - block * blockInts]);
+            cache->unpin(block);
+            begin = blockEnd;
+        }
+        return true;
+    }
+
+    bool readFailed() const { return failed; }
+
+private:
+    int fd = -1;
+    std::vector<int64_t> offsets;
+    std::unique_ptr<BlockCache> cache;
+    mutable bool failed = false;
+};
+
+template <>
+struct GraphTraits<OutOfCoreGraph> {
+    static const bool contiguous = false;
+
+    static int numVertices(const OutOfCoreGraph &g) { return g.numVertices(); }
+
+    template <typename F>
+    static void forEachNeighbor(const OutOfCoreGraph &g, int v, F f) {
+        g.forEachNeighbor(v, f);
+    }
+};
+
+struct OutOfCoreStats {
+    int64_t deferredVertices = 0; // pops parked because their block was not resident
+    int64_t blockSwitches = 0;    // pending lists drained
+};
+
+// Engine hooks of dfsOutOfCore: records the visit order, parks neighbors
+// whose block is not resident and stops on a read error.
+class BlockGroupingVisitor : public DfsVisitor {
+public:
+    BlockGroupingVisitor(OutOfCoreGraph &graph, std::vector<int> &res, OutOfCoreStats &stats)
+        : graph(graph), cache(graph.blocks()), res(res), stats(stats), pending(cache.blockCount()) {}
+
+    bool stopRequested() const { return graph.readFailed(); }
+
+    bool discover(int v) {
+        res.push_back(v);
+        return true;
+    }
+
+    bool follow(int u) {
+        int64_t block = graph.firstBlock(u);
+        if (block >= cache.blockCount() || block == currentBlock || cache.resident(block))
+            return true;
+        if (pending[block].empty())
+            pendingBlocks.push_back(block);
+        pending[block].push_back(u);
+        stats.deferredVertices++;
+        return false;
+    }
+
+    // Releases the current block, then pins the next one with parked
+    // vertices and moves them onto stack. Returns false when none are left
+    // or the block cannot be read.
+    bool nextBlock(std::vector<int> &stack) {
+        releaseBlock();
+        if (pendingBlocks.empty())
+            return false;
+
+        int64_t block = takeNextBlock();
+        if (!cache.pin(block))
+        {
+            pinFailed = true;
+            return false;
+        }
+        currentBlock = block;
+        // Read the likely next block while this one is being processed.
+        if (!pendingBlocks.empty())
+            cache.prefetch(pendingBlocks[pickNextBlock()]);
+        stats.blockSwitches++;
+        std::vector<int> &parked = pending[block];
+        stack.insert(stack.end(), parked.rbegin(), parked.rend());
+        parked.clear();
+        parked.shrink_to_fit();
+        return true;
+    }
+
+    void releaseBlock() {
+        if (currentBlock >= 0)
+            cache.unpin(currentBlock);
+        currentBlock = -1;
+    }
+
+    bool failed() const { return pinFailed || graph.readFailed(); }
+
+private:
+    // Prefer a block that is already resident, else the fullest one.
+    size_t pickNextBlock() const {
+        size_t best = 0;
+        for (size_t k = 0; k < pendingBlocks.size(); k++)
+        {
+            int64_t b = pendingBlocks[k];
+            if (cache.resident(b))
+                return k;
+            if (pending[b].size() > pending[pendingBlocks[best]].size())
+                best = k;
+        }
+        return best;
+    }
+
+    int64_t takeNextBlock() {
+        size_t best = pickNextBlock();
+        int64_t block = pendingBlocks[best];
+        pendingBlocks[best] = pendingBlocks.back();
+        pendingBlocks.pop_back();
+        return block;
+    }
+
+    OutOfCoreGraph &graph;
+    BlockCache &cache;
+    std::vector<int> &res;
+    OutOfCoreStats &stats;
+    std::vector<std::vector<int>> pending;
+    std::vector<int64_t> pendingBlocks; // blocks with a non-empty pending list
+    int64_t currentBlock = -1;          // pinned while its parked vertices are processed
+    bool pinFailed = false;
+};
+
+// Block-grouped DFS over an out-of-core graph (see the top of this file).
+// Returns false, with res holding the vertices visited so far, if a block
+// cannot be read.
+inline bool dfsOutOfCore(OutOfCoreGraph &graph, std::vector<int> &res, OutOfCoreStats &stats) {
+    int n = graph.numVertices();
+    BitmapVisited visited(n);
+    res.clear();
+    BlockGroupingVisitor visitor(graph, res, stats);
+    std::vector<int> stack;
+
+    for (int root = 0; root < n; root++)
+    {
+        if (visited.isVisited(root))
+            continue;
+        if (visitor.follow(root))
+            stack.push_back(root);
+        do
+        {
+            if (dfsDrain(graph, visited, stack, visitor))
+                break;
+        } while (visitor.nextBlock(stack));
+
+        if (visitor.failed())
+        {
+            visitor.releaseBlock();
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,95 +1,50 @@
 #include <iostream>
 #include <vector>
+#include <string>
+#include <cstring>
 #include <omp.h>
+#include "dfs_engine.h"
+#include "numa_placement.h"
+#include "result_sink.h"
 using namespace std;
 
-void dfsRec(vector<vector<int>> &adj, vector<bool> &visited, int s, vector<int> &res, int stride) {
-    #pragma omp critical
-    {
-        if (!visited[s])
-        {
-            visited[s] = true;
-            res.push_back(s);
-        }
-    }
-
-    double work = 0;
-    for (int i = 0; i < 1000; i++)
-    {
-        work += (s * i) % 100;
-    }
-
-    for (int idx = 0; idx < adj[s].size(); idx += stride)
-    {
-        int i = adj[s][idx];
-        bool needsVisit = false;
-
-        #pragma omp critical
-        {
-            needsVisit = !visited[i];
-        }
-
-        if (needsVisit)
-        {
-            #pragma omp task shared(adj, visited, res)
-            {
-                dfsRec(adj, visited, i, res, stride);
-            }
-        }
-    }
-    
-    for (int idx = 0; idx < adj[s].size(); idx++)
-    {
-        if (idx % stride != 0)
-        {
-            int i = adj[s][idx];
-            bool needsVisit = false;
-
-            #pragma omp critical
-            {
-                needsVisit = !visited[i];
-            }
+// Pinned threads with socket-aware work stealing over a graph whose pages
+// were first touched by the threads that traverse them
+vector<int> dfs(const NumaCSRGraph &graph, const ThreadPlacement &placement, int stride, StealStats &steals) {
+    DfsOptions options;
+    options.stride = stride;
+    return dfsParallelNuma(graph, placement, steals, options, true);
+}
 
-            if (needsVisit) {
-                #pragma omp task shared(adj, visited, res)
-                {
-                    dfsRec(adj, visited, i, res, stride);
-                }
-            }
-        }
-    }
-    #pragma omp taskwait
+// Streams the order to path instead of keeping it: each thread stages its
+// visits and hands them to one writer in chunks. Returns the number of
+// vertices written, or -1 if the file cannot be written.
+long long dfsToFile(const NumaCSRGraph &graph, const ThreadPlacement &placement, int stride, StealStats &steals,
+                    const string &path) {
+    AsyncOrderWriter writer;
+    if (!writer.open(path, OrderFormat::DeltaVarint))
+        return -1;
+    SharedSinkVisitor<AsyncOrderWriter> visitor(writer, true);
+    DfsOptions options;
+    options.stride = stride;
+    dfsParallelNumaWith(graph, placement, visitor, steals, options);
+    visitor.finish();
+    return writer.close() ? writer.verticesWritten() : -1;
 }
 
-vector<int> dfs(vector<vector<int>> &adj, int stride)
+int main(int argc, char **argv)
 {
-    vector<bool> visited(adj.size(), false);
-    vector<int> res;
-
-    #pragma omp parallel
+    // --output=PATH writes each run's order to PATH.stride<N> (see
+    // result_sink.h for the format) instead of printing its start
+    string outputPath;
+    for (int i = 1; i < argc; i++)
     {
-        #pragma omp single
+        if (strncmp(argv[i], "--output=", 9) == 0)
         {
-            for (int i = 0; i < adj.size(); i++)
-            {
-                bool needsVisit = false;
-                #pragma omp critical
-                {
-                    needsVisit = !visited[i];
-                }
-
-                if (needsVisit)
-                {
-                    dfsRec(adj, visited, i, res, stride);
-                }
-            }
+            outputPath = argv[i] + 9;
         }
     }
-    return res;
-}
 
-int main()
-{
     int numVertices = 50000;
     vector<vector<int>> adj(numVertices);
 
@@ -108,7 +63,16 @@ int main()
         }
     }
 
+    // Each pinned thread copies the vertex range it starts from, so its
+    // offsets, neighbors and visited flags land on its own node.
+    NumaTopology topology = NumaTopology::detect();
+    ThreadPlacement placement(topology, omp_get_max_threads());
+    NumaCSRGraph graph(CSRGraph(adj), placement, topology, NumaPolicy::FirstTouch);
+    adj.clear();
+    adj.shrink_to_fit();
+
     cout << "Graph created successfully!" << endl;
+    cout << "NUMA nodes: " << topology.numNodes() << endl;
 
     int strides[] = {1, 2, 4, 8, 16};
     int num_strides = sizeof(strides) / sizeof(strides[0]);
@@ -119,24 +83,49 @@ int main()
         cout << "DFS Traversal of the graph (Parallel):" << endl;
         cout << "Stride size: " << stride << endl;
 
+        string path = outputPath + ".stride" + to_string(stride);
         double start = omp_get_wtime();
 
-        vector<int> result = dfs(adj, stride);
+        StealStats steals;
+        vector<int> result;
+        long long written = 0;
+        if (outputPath.empty())
+        {
+            result = dfs(graph, placement, stride, steals);
+        }
+        else
+        {
+            written = dfsToFile(graph, placement, stride, steals, path);
+        }
 
         double end = omp_get_wtime();
 
         double time_seconds = end - start;
         double time_ms = time_seconds * 1000.0;
 
-        cout << "Total vertices visited: " << result.size() << endl;
-        cout << "First 10 vertices: ";
-        for (int i = 0; i < 10 && i < result.size(); i++)
+        if (outputPath.empty())
+        {
+            cout << "Total vertices visited: " << result.size() << endl;
+            cout << "First 10 vertices: ";
+            for (int i = 0; i < 10 && i < result.size(); i++)
+            {
+                cout << result[i] << " ";
+            }
+            cout << "..." << endl;
+        }
+        else if (written < 0)
+        {
+            cerr << "Could not write " << path << endl;
+            return 1;
+        }
+        else
         {
-            cout << result[i] << " ";
+            cout << "Total vertices visited: " << written << endl;
+            cout << "Order written to " << path << endl;
         }
-        cout << "..." << endl;
         cout << "Execution time: " << time_ms << " milliseconds (ms)" << endl;
         cout << "Number of threads used: " << omp_get_max_threads() << endl;
+        cout << "Steals: " << steals.localSteals << " on the same node, " << steals.remoteSteals << " across nodes" << endl;
         cout << endl;
     }
 
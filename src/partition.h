@@ -0,0 +1,217 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+// Graph partitioning for the MPI domain decomposition.
+//
+// labelPropagationPartition starts from contiguous blocks of equal edge
+// weight and then repeatedly moves each vertex to the part most of its
+// neighbors live in, as long as the target part stays under the balance
+// limit (size-constrained label propagation). Vertex weight is out-degree
+// plus one, so parts end up with balanced edge counts rather than balanced
+// vertex counts. relabelByPart then renumbers vertices so every part is a
+// contiguous ID range and owner lookup stays a range check.
+//
+// blockPartitionByVertices is the original 1D split with equal vertex
+// counts, kept as the baseline to compare the others against.
+
+// Neighbors in both directions; label propagation looks at in-edges too.
+inline std::vector<std::vector<int>> undirectedNeighbors(const std::vector<std::vector<int>> &adj) {
+    int n = adj.size();
+    std::vector<std::vector<int>> und(n);
+    for (int s = 0; s < n; s++)
+    {
+        for (int i : adj[s])
+        {
+            if (i == s)
+                continue;
+            und[s].push_back(i);
+            und[i].push_back(s);
+        }
+    }
+    return und;
+}
+
+// Contiguous blocks of equal vertex count; the first n % numParts blocks
+// get one vertex more
+inline std::vector<int> blockPartitionByVertices(int n, int numParts) {
+    int baseSize = n / numParts;
+    int remainder = n % numParts;
+    int threshold = remainder * (baseSize + 1);
+
+    std::vector<int> owner(n);
+    for (int s = 0; s < n; s++)
+        owner[s] = s < threshold ? s / (baseSize + 1) : remainder + (s - threshold) / baseSize;
+    return owner;
+}
+
+// Contiguous blocks with roughly equal sum of (out-degree + 1)
+inline std::vector<int> blockPartitionByEdges(const std::vector<std::vector<int>> &adj, int numParts) {
+    int n = adj.size();
+    long long totalWeight = 0;
+    for (int s = 0; s < n; s++)
+        totalWeight += adj[s].size() + 1;
+
+    std::vector<int> owner(n);
+    long long prefix = 0;
+    for (int s = 0; s < n; s++)
+    {
+        int part = (int)(prefix * numParts / totalWeight);
+        owner[s] = std::min(part, numParts - 1);
+        prefix += adj[s].size() + 1;
+    }
+    return owner;
+}
+
+inline std::vector<int> labelPropagationPartition(const std::vector<std::vector<int>> &adj, int numParts,
+                                                  int rounds = 10, double imbalance = 0.03) {
+    int n = adj.size();
+    std::vector<int> owner = blockPartitionByEdges(adj, numParts);
+    if (numParts <= 1)
+        return owner;
+
+    std::vector<std::vector<int>> und = undirectedNeighbors(adj);
+
+    std::vector<long long> load(numParts, 0);
+    long long totalWeight = 0;
+    long long maxVertexWeight = 0;
+    for (int s = 0; s < n; s++)
+    {
+        long long w = adj[s].size() + 1;
+        load[owner[s]] += w;
+        totalWeight += w;
+        maxVertexWeight = std::max(maxVertexWeight, w);
+    }
+    long long maxLoad = std::max((long long)((1.0 + imbalance) * totalWeight / numParts) + 1,
+                                 totalWeight / numParts + maxVertexWeight);
+
+    for (int round = 0; round < rounds; round++)
+    {
+        int moved = 0;
+
+        #pragma omp parallel reduction(+:moved)
+        {
+            std::vector<int> connections(numParts, 0);
+            std::vector<int> touched;
+
+            #pragma omp for schedule(dynamic, 1024)
+            for (int s = 0; s < n; s++)
+            {
+                int from;
+                #pragma omp atomic read
+                from = owner[s];
+
+                for (int i : und[s])
+                {
+                    int part;
+                    #pragma omp atomic read
+                    part = owner[i];
+
+                    if (connections[part]++ == 0)
+                        touched.push_back(part);
+                }
+
+                // Only strict gains move a vertex; ties would make parts oscillate.
+                long long w = adj[s].size() + 1;
+                int best = from;
+                for (int part : touched)
+                {
+                    long long partLoad;
+                    #pragma omp atomic read
+                    partLoad = load[part];
+
+                    if (connections[part] > connections[best] && partLoad + w <= maxLoad)
+                        best = part;
+                }
+
+                if (best != from)
+                {
+                    long long newLoad;
+                    #pragma omp atomic capture
+                    newLoad = load[best] += w;
+
+                    if (newLoad <= maxLoad)
+                    {
+                        #pragma omp atomic
+                        load[from] -= w;
+                        #pragma omp atomic write
+                        owner[s] = best;
+                        moved++;
+                    }
+                    else
+                    {
+                        #pragma omp atomic
+                        load[best] -= w;
+                    }
+                }
+
+                for (int part : touched)
+                    connections[part] = 0;
+                touched.clear();
+            }
+        }
+
+        if (moved == 0)
+            break;
+    }
+    return owner;
+}
+
+// Number of directed edges whose endpoints live in different parts
+inline long long countCutEdges(const std::vector<std::vector<int>> &adj, const std::vector<int> &owner) {
+    long long cut = 0;
+    int n = adj.size();
+
+    #pragma omp parallel for reduction(+:cut) schedule(static)
+    for (int s = 0; s < n; s++)
+        for (int i : adj[s])
+            if (owner[s] != owner[i])
+                cut++;
+    return cut;
+}
+
+// Renumbering that makes every part a contiguous range of vertex IDs.
+// Vertices keep their original relative order inside a part.
+struct Relabeling {
+    std::vector<int> newId;      // original ID -> relabeled ID
+    std::vector<int> oldId;      // relabeled ID -> original ID
+    std::vector<int> partStart;  // part p owns [partStart[p], partStart[p + 1])
+};
+
+inline Relabeling relabelByPart(const std::vector<int> &owner, int numParts) {
+    int n = owner.size();
+    Relabeling relabel;
+    relabel.partStart.assign(numParts + 1, 0);
+    for (int s = 0; s < n; s++)
+        relabel.partStart[owner[s] + 1]++;
+    for (int p = 0; p < numParts; p++)
+        relabel.partStart[p + 1] += relabel.partStart[p];
+
+    std::vector<int> next(relabel.partStart.begin(), relabel.partStart.end() - 1);
+    relabel.newId.resize(n);
+    relabel.oldId.resize(n);
+    for (int s = 0; s < n; s++)
+    {
+        int id = next[owner[s]]++;
+        relabel.newId[s] = id;
+        relabel.oldId[id] = s;
+    }
+    return relabel;
+}
+
+inline std::vector<std::vector<int>> applyRelabeling(const std::vector<std::vector<int>> &adj, const Relabeling &relabel) {
+    int n = adj.size();
+    std::vector<std::vector<int>> out(n);
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int s = 0; s < n; s++)
+    {
+        std::vector<int> &neighbors = out[relabel.newId[s]];
+        neighbors.reserve(adj[s].size());
+        for (int i : adj[s])
+            neighbors.push_back(relabel.newId[i]);
+    }
+    return out;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include "csr_graph.h"
+#include "dfs_engine.h"
+#include "traversal_context.h"
+
+// Bidirectional s-t path search.
+//
+// One search grows forward from s over the graph, the other backward from t
+// over its transpose; the path is found where they meet. Each round expands
+// one full level of whichever side has the smaller frontier. On small-world
+// graphs two searches of depth d/2 touch far fewer vertices than one of
+// depth d. Each side records who discovered every vertex, so the path is
+// read back from the meeting vertex in both directions.
+//
+// Expanding whole levels makes the result a shortest path. When a side
+// expands level k and finds a vertex the other side has seen, the other side
+// has finished every level but its last, so no shorter path through a
+// different meeting vertex exists.
+//
+// bidirectionalPathParallel splits large frontiers across threads, level
+// by level like topoSortParallel: vertices are claimed with an atomic
+// visited stamp, each thread collects its part of the next level, and the
+// parts are concatenated. Only one side changes during a level, so checking
+// the other side needs no synchronization.
+
+// Reverse graph for the backward search: v -> u for every edge u -> v.
+template <typename Graph>
+inline CSRGraph transposeGraph(const Graph &g) {
+    int n = GraphTraits<Graph>::numVertices(g);
+    CSRGraph reverse;
+    reverse.offsets.assign(n + 1, 0);
+    for (int u = 0; u < n; u++)
+        GraphTraits<Graph>::forEachNeighbor(g, u, [&](int v) { reverse.offsets[v + 1]++; });
+    for (int v = 0; v < n; v++)
+        reverse.offsets[v + 1] += reverse.offsets[v];
+    reverse.neighbors.resize(reverse.offsets[n]);
+    std::vector<int64_t> fill(reverse.offsets.begin(), reverse.offsets.end() - 1);
+    for (int u = 0; u < n; u++)
+        GraphTraits<Graph>::forEachNeighbor(g, u, [&](int v) { reverse.neighbors[fill[v]++] = u; });
+    return reverse;
+}
+
+// Reusable per-thread state of one search direction.
+struct PathSide {
+    TraversalContext seen;
+    std::vector<int> parent; // valid for seen vertices; -1 at the endpoint
+    std::vector<int> frontier;
+    std::vector<int> next;
+
+    void begin(int n, int endpoint) {
+        seen.begin(n);
+        if ((int)parent.size() < n)
+            parent.resize(n);
+        seen.markVisited(endpoint);
+        parent[endpoint] = -1;
+        frontier.assign(1, endpoint);
+    }
+};
+
+struct PathScratch {
+    PathSide forward;
+    PathSide backward;
+    long long expanded = 0; // vertices expanded by the last search
+    std::vector<std::vector<int>> nextLocal; // per-thread next levels
+    std::vector<size_t> offsets;
+};
+
+// s ... meet from the forward parents, then meet ... t from the backward ones.
+inline void joinPath(const PathScratch &scratch, int meet, std::vector<int> &path) {
+    path.clear();
+    for (int v = meet; v != -1; v = scratch.forward.parent[v])
+        path.push_back(v);
+    std::reverse(path.begin(), path.end());
+    for (int v = scratch.backward.parent[meet]; v != -1; v = scratch.backward.parent[v])
+        path.push_back(v);
+}
+
+// Expands one level of side; returns a vertex other has seen, or -1.
+template <typename Graph>
+inline int expandLevel(const Graph &g, PathSide &side, const PathSide &other) {
+    side.next.clear();
+    for (int x : side.frontier)
+    {
+        int meet = -1;
+        GraphTraits<Graph>::forEachNeighbor(g, x, [&](int y) {
+            if (meet != -1 || !side.seen.markVisited(y))
+                return;
+            side.parent[y] = x;
+            if (other.seen.isVisited(y))
+                meet = y;
+            side.next.push_back(y);
+        });
+        if (meet != -1)
+            return meet;
+    }
+    side.frontier.swap(side.next);
+    return -1;
+}
+
+// Parallel expandLevel over numThreads threads.
+template <typename Graph>
+inline int expandLevelParallel(const Graph &g, PathSide &side, const PathSide &other, PathScratch &scratch,
+                               int numThreads) {
+    scratch.nextLocal.resize(numThreads);
+    scratch.offsets.assign(numThreads + 1, 0);
+    std::atomic<int> meet(-1);
+    int frontierSize = side.frontier.size();
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        int tid = engineThreadNum();
+        std::vector<int> &next = scratch.nextLocal[tid];
+        next.clear();
+
+        #pragma omp for schedule(dynamic, 64)
+        for (int k = 0; k < frontierSize; k++)
+        {
+            if (meet.load(std::memory_order_relaxed) != -1)
+                continue;
+            int x = side.frontier[k];
+            GraphTraits<Graph>::forEachNeighbor(g, x, [&](int y) {
+                if (side.seen.isVisited(y) || !side.seen.claimVisited(y))
+                    return;
+                side.parent[y] = x;
+                if (other.seen.isVisited(y))
+                {
+                    int none = -1;
+                    meet.compare_exchange_strong(none, y);
+                }
+                next.push_back(y);
+            });
+        }
+
+        #pragma omp single
+        for (int t = 0; t < numThreads; t++)
+            scratch.offsets[t + 1] = scratch.offsets[t] + scratch.nextLocal[t].size();
+
+        if (meet.load() == -1)
+        {
+            #pragma omp single
+            side.frontier.resize(scratch.offsets[numThreads]);
+            std::copy(next.begin(), next.end(), side.frontier.begin() + scratch.offsets[tid]);
+        }
+    }
+    return meet.load();
+}
+
+// Shortest path from s to t into path, empty if t is unreachable. reverse
+// must be the transpose of g. Returns whether a path exists.
+template <typename Graph, typename Reverse>
+inline bool bidirectionalPath(const Graph &g, const Reverse &reverse, int s, int t, PathScratch &scratch,
+                              std::vector<int> &path) {
+    int n = GraphTraits<Graph>::numVertices(g);
+    scratch.forward.begin(n, s);
+    scratch.backward.begin(n, t);
+    scratch.expanded = 0;
+    path.clear();
+    if (s == t)
+    {
+        path.push_back(s);
+        return true;
+    }
+
+    while (!scratch.forward.frontier.empty() && !scratch.backward.frontier.empty())
+    {
+        bool forward = scratch.forward.frontier.size() <= scratch.backward.frontier.size();
+        PathSide &side = forward ? scratch.forward : scratch.backward;
+        scratch.expanded += side.frontier.size();
+        int meet = forward ? expandLevel(g, scratch.forward, scratch.backward)
+                           : expandLevel(reverse, scratch.backward, scratch.forward);
+        if (meet != -1)
+        {
+            joinPath(scratch, meet, path);
+            return true;
+        }
+    }
+    return false;
+}
+
+// bidirectionalPath with levels of at least parallelThreshold vertices
+// expanded by numThreads threads (0 means all of them).
+template <typename Graph, typename Reverse>
+inline bool bidirectionalPathParallel(const Graph &g, const Reverse &reverse, int s, int t, PathScratch &scratch,
+                                      std::vector<int> &path, int numThreads = 0, int parallelThreshold = 1024) {
+    int n = GraphTraits<Graph>::numVertices(g);
+    if (numThreads <= 0)
+        numThreads = engineMaxThreads();
+    scratch.forward.begin(n, s);
+    scratch.backward.begin(n, t);
+    scratch.expanded = 0;
+    path.clear();
+    if (s == t)
+    {
+        path.push_back(s);
+        return true;
+    }
+
+    while (!scratch.forward.frontier.empty() && !scratch.backward.frontier.empty())
+    {
+        bool forward = scratch.forward.frontier.size() <= scratch.backward.frontier.size();
+        PathSide &side = forward ? scratch.forward : scratch.backward;
+        PathSide &other = forward ? scratch.backward : scratch.forward;
+        scratch.expanded += side.frontier.size();
+        bool parallel = numThreads > 1 && (int)side.frontier.size() >= parallelThreshold;
+        int meet;
+        if (forward)
+            meet = parallel ? expandLevelParallel(g, side, other, scratch, numThreads) : expandLevel(g, side, other);
+        else
+            meet = parallel ? expandLevelParallel(reverse, side, other, scratch, numThreads)
+                            : expandLevel(reverse, side, other);
+        if (meet != -1)
+        {
+            joinPath(scratch, meet, path);
+            return true;
+        }
+    }
+    return false;
+}
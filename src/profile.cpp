@@ -5,114 +5,212 @@
 #include <iomanip>
 #include <fstream>
 #include <cmath>
+#include "topo_sort.h"
+#include "out_of_core.h"
+#include "compressed_graph.h"
+#include "simd_filter.h"
+#include "numa_placement.h"
+#include "arena.h"
+#include "traversal_context.h"
+#include "dfs_engine.h"
+#include "dfs_generator.h"
+#include "result_sink.h"
+#include "incremental_dfs.h"
+#include "versioned_graph.h"
+#include "reach_cache.h"
+#include "reach_index.h"
+#include "path_search.h"
+#include <atomic>
+#include <cstdlib>
 using namespace std;
 
-// Serial DFS implementation
-void dfsRecSerial(vector<vector<int>> &adj, vector<bool> &visited, int s, vector<int> &res) {
-    visited[s] = true;
-    res.push_back(s);
+#ifdef COUNT_ALLOCATIONS
+// Count heap allocations so the arena section can report what it saves.
+// Only with -DCOUNT_ALLOCATIONS: the counting operator new slows down every
+// other benchmark too. The operators are kept out of line so the compiler
+// never sees free() applied to what new returned.
+static atomic<long long> heapAllocations(0);
 
-    double work = 0;
-    for (int i = 0; i < 1000; i++)
-    {
-        work += (s * i) % 100;
-    }
+__attribute__((noinline)) void *operator new(size_t bytes) {
+    heapAllocations++;
+    if (void *p = malloc(bytes))
+        return p;
+    throw bad_alloc();
+}
+
+__attribute__((noinline)) void *operator new[](size_t bytes) { return operator new(bytes); }
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void *p, size_t) noexcept { free(p); }
+
+const bool countingAllocations = true;
+long long heapAllocationCount() { return heapAllocations.load(); }
+#else
+const bool countingAllocations = false;
+long long heapAllocationCount() { return 0; }
+#endif
 
-    for (int i : adj[s])
-        if (visited[i] == false)
-            dfsRecSerial(adj, visited, i, res);
+// Serial DFS: the shared engine with the per-vertex simulated work. The
+// full traversal reuses ctx's visited stamps and result buffer.
+const vector<int> &dfsSerial(vector<vector<int>> &adj, TraversalContext &ctx) {
+    ctx.begin(adj.size());
+    ContextVisited<false> visited(ctx);
+    OrderCollector visitor(true);
+    dfsRunWith(Sequential(), adj, visited, visitor);
+    visitor.appendOrder(ctx.result());
+    return ctx.result();
 }
 
 vector<int> dfsSerial(vector<vector<int>> &adj) {
-    vector<bool> visited(adj.size(), false);
-    vector<int> res;
+    TraversalContext ctx(adj.size());
+    return dfsSerial(adj, ctx);
+}
 
-    for (int i = 0; i < adj.size(); i++)
-    {
-        if (visited[i] == false)
-        {
-            dfsRecSerial(adj, visited, i, res);
-        }
-    }
-    return res;
+// Parallel DFS: the same engine with OpenMP tasks
+const vector<int> &dfsParallel(vector<vector<int>> &adj, TraversalContext &ctx)
+{
+    ctx.begin(adj.size());
+    ContextVisited<true> visited(ctx);
+    OrderCollector visitor(true);
+    dfsRunWith(OmpTasks(), adj, visited, visitor);
+    visitor.appendOrder(ctx.result());
+    return ctx.result();
+}
+
+vector<int> dfsParallel(vector<vector<int>> &adj)
+{
+    TraversalContext ctx(adj.size());
+    return dfsParallel(adj, ctx);
 }
 
-// Parallel DFS implementation
-void dfsRecParallel(vector<vector<int>> &adj, vector<bool> &visited, int s, vector<int> &res) {
-    #pragma omp critical
+// Create test graph
+vector<vector<int>> createGraph(int numVertices) {
+    vector<vector<int>> adj(numVertices);
+
+    for (int i = 0; i < numVertices; i++)
     {
-        if (!visited[s])
+        int connections = 2 + (i % 3);
+        for (int j = 1; j <= connections; j++)
         {
-            visited[s] = true;
-            res.push_back(s);
+            int neighbor = (i * 7 + j * 13) % numVertices;
+            if (neighbor != i)
+            {
+                adj[i].push_back(neighbor);
+            }
         }
     }
+    return adj;
+}
 
-    double work = 0;
-    for (int i = 0; i < 1000; i++)
-    {
-        work += (s * i) % 100;
-    }
+// Create test DAG: same generator, but only edges to higher-numbered vertices
+vector<vector<int>> createDAG(int numVertices) {
+    vector<vector<int>> adj(numVertices);
 
-    for (int i : adj[s])
+    for (int i = 0; i < numVertices; i++)
     {
-        bool needsVisit = false;
-
-        #pragma omp critical
+        int connections = 2 + (i % 3);
+        for (int j = 1; j <= connections; j++)
         {
-            needsVisit = !visited[i];
-        }
-
-        if (needsVisit) {
-            #pragma omp task shared(adj, visited, res)
+            int neighbor = (i * 7 + j * 13) % numVertices;
+            if (neighbor > i)
             {
-                dfsRecParallel(adj, visited, i, res);
+                adj[i].push_back(neighbor);
             }
         }
     }
-    #pragma omp taskwait
+    return adj;
 }
 
-vector<int> dfsParallel(vector<vector<int>> &adj)
-{
-    vector<bool> visited(adj.size(), false);
-    vector<int> res;
+// Create test graph with hubs: every 1000th vertex gets hubDegree extra
+// pseudo-random neighbors on top of the createGraph edges
+vector<vector<int>> createHubGraph(int numVertices, int hubDegree) {
+    vector<vector<int>> adj = createGraph(numVertices);
 
-    #pragma omp parallel
+    for (int h = 0; h < numVertices; h += 1000)
     {
-        #pragma omp single
+        for (int j = 0; j < hubDegree; j++)
         {
-            for (int i = 0; i < adj.size(); i++)
-            {
-                if (visited[i] == false)
-                {
-                    dfsRecParallel(adj, visited, i, res);
-                }
-            }
+            adj[h].push_back((int)(((long long)h * 2654435761LL + (long long)j * 40503) % numVertices));
         }
     }
-    return res;
+    return adj;
 }
 
-// Create test graph
-vector<vector<int>> createGraph(int numVertices) {
+// Create test graph with uniformly scattered neighbors, so that every
+// adjacency and visited lookup misses in cache once the graph is large
+vector<vector<int>> createScatteredGraph(int numVertices) {
     vector<vector<int>> adj(numVertices);
+    uint64_t state = 88172645463325252ULL;
 
     for (int i = 0; i < numVertices; i++)
     {
         int connections = 2 + (i % 3);
-        for (int j = 1; j <= connections; j++)
+        for (int j = 0; j < connections; j++)
         {
-            int neighbor = (i * 7 + j * 13) % numVertices;
-            if (neighbor != i)
-            {
-                adj[i].push_back(neighbor);
-            }
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            adj[i].push_back(state % numVertices);
+        }
+    }
+    return adj;
+}
+
+// createScatteredGraph's edges as a generator for BasicCSRGraph::assign.
+// The state restarts at vertex 0, so both passes see the same edges.
+auto scatteredEdges(int numVertices) {
+    uint64_t state = 0;
+    return [numVertices, state](int i, auto emit) mutable {
+        if (i == 0)
+            state = 88172645463325252ULL;
+        int connections = 2 + (i % 3);
+        for (int j = 0; j < connections; j++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            emit(state % numVertices);
+        }
+    };
+}
+
+// Create test graph whose first eighth holds every edge: 32 scattered
+// neighbors per vertex, all inside that eighth. The other vertices are
+// isolated, so threads that own them run out of roots early.
+vector<vector<int>> createSkewedGraph(int numVertices) {
+    vector<vector<int>> adj(numVertices);
+    int heavy = max(numVertices / 8, 1);
+    uint64_t state = 88172645463325252ULL;
+
+    for (int i = 0; i < heavy; i++)
+    {
+        for (int j = 0; j < 32; j++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            adj[i].push_back(state % heavy);
         }
     }
     return adj;
 }
 
+// Measure execution time for a topological sort implementation
+double measureTopoTime(vector<vector<int>> &adj, TopoResult (*topoSort)(const vector<vector<int>> &),
+                       TopoResult &result, int iterations = 5) {
+    double sum = 0;
+
+    for (int iter = 0; iter < iterations; iter++) {
+        auto start = chrono::high_resolution_clock::now();
+        result = topoSort(adj);
+        auto end = chrono::high_resolution_clock::now();
+
+        chrono::duration<double> duration = end - start;
+        sum += duration.count();
+    }
+    return sum / iterations;
+}
+
 // Measure execution time for serial version
 double measureSerialTime(vector<vector<int>> &adj, int iterations = 5) {
     vector<double> times;
@@ -224,6 +322,909 @@ int main()
     
     cout << "\nSerial Time (T_S): " << fixed << setprecision(6) << T_S << " seconds" << endl;
     
+    // Topological sort: serial DFS postorder vs parallel level-synchronous Kahn
+    cout << "\n\n===========================================" << endl;
+    cout << "TOPOLOGICAL SORT" << endl;
+    cout << "===========================================" << endl;
+    vector<vector<int>> dag = createDAG(numVertices);
+    
+    TopoResult topoResult;
+    double T_topoSerial = measureTopoTime(dag, topoSortSerial, topoResult, iterations);
+    bool serialValid = !topoResult.hasCycle && isTopologicalOrder(dag, topoResult.order);
+    cout << "Serial (DFS postorder): " << fixed << setprecision(6) << T_topoSerial << " seconds"
+         << (serialValid ? "" : " [INVALID ORDER]") << endl;
+    
+    vector<double> T_topoParallel;
+    for (int threads : threadCounts) {
+        omp_set_num_threads(threads);
+        double T = measureTopoTime(
+            dag, [](const vector<vector<int>> &g) { return topoSortParallel(g); }, topoResult, iterations);
+        T_topoParallel.push_back(T);
+        bool valid = !topoResult.hasCycle && isTopologicalOrder(dag, topoResult.order);
+        cout << "Parallel Kahn (" << threads << " threads): " << fixed << setprecision(6) << T << " seconds"
+             << ", speedup " << setprecision(4) << (T_topoSerial / T)
+             << (valid ? "" : " [INVALID ORDER]") << endl;
+    }
+    
+    // The DFS test graph wraps around, so it must be rejected with a witness cycle
+    TopoResult cyclic = topoSortParallel(adj);
+    if (cyclic.hasCycle) {
+        cout << "Cycle detected in DFS test graph, witness length " << cyclic.cycle.size() << ": ";
+        for (size_t i = 0; i < 10 && i < cyclic.cycle.size(); i++) {
+            cout << cyclic.cycle[i] << " ";
+        }
+        cout << "..." << endl;
+    }
+    
+    // Out-of-core: adjacency on disk, only a small block cache in memory
+    cout << "\n\n===========================================" << endl;
+    cout << "OUT-OF-CORE DFS" << endl;
+    cout << "===========================================" << endl;
+    const int blockInts = 4096;
+    const string graphPath = "graph.bin";
+    int64_t numEdges = 0;
+    for (auto &neighbors : adj)
+        numEdges += neighbors.size();
+    int64_t totalBlocks = (numEdges + blockInts - 1) / blockInts;
+    int cacheBlocks = max<int64_t>(2, totalBlocks / 8); // an eighth of the file
+    double T_outOfCore = 0;
+    int64_t blocksRead = 0, deferred = 0;
+    bool outOfCoreOk = false;
+    if (writeGraphFile(graphPath, adj)) {
+        for (int iter = 0; iter < iterations; iter++) {
+            OutOfCoreGraph diskGraph;
+            if (!diskGraph.open(graphPath, blockInts, cacheBlocks))
+                break;
+
+            OutOfCoreStats stats;
+            auto start = chrono::high_resolution_clock::now();
+            vector<int> result;
+            bool readOk = dfsOutOfCore(diskGraph, result, stats);
+            auto end = chrono::high_resolution_clock::now();
+
+            chrono::duration<double> duration = end - start;
+            T_outOfCore += duration.count() / iterations;
+            blocksRead = diskGraph.blocks().blocksRead();
+            deferred = stats.deferredVertices;
+            outOfCoreOk = readOk && (int)result.size() == numVertices;
+        }
+        remove(graphPath.c_str());
+    }
+    cout << "Cache: " << cacheBlocks << " of " << totalBlocks << " blocks (" << blockInts << " neighbors each)" << endl;
+    cout << "Time: " << fixed << setprecision(6) << T_outOfCore << " seconds"
+         << (outOfCoreOk ? "" : " [INCOMPLETE]") << endl;
+    cout << "Blocks read: " << blocksRead << ", deferred vertices: " << deferred << endl;
+    
+    // Compressed adjacency: stream-vbyte deltas, SIMD vs scalar decode
+    cout << "\n\n===========================================" << endl;
+    cout << "COMPRESSED ADJACENCY" << endl;
+    cout << "===========================================" << endl;
+    CompressedGraph compressed(adj);
+    size_t rawBytes = adj.size() * sizeof(vector<int>) + numEdges * sizeof(int);
+    size_t compressedBytes = compressed.memoryBytes();
+    double T_decode[2] = {0, 0}; // scalar, SIMD
+    bool compressedOk = true;
+    for (int simd = 0; simd < 2; simd++) {
+        compressed.setSIMD(simd);
+        for (int iter = 0; iter < iterations; iter++) {
+            auto start = chrono::high_resolution_clock::now();
+            OrderCollector visitor;
+            dfsRun(Sequential(), compressed, visitor);
+            vector<int> result = visitor.order();
+            auto end = chrono::high_resolution_clock::now();
+
+            chrono::duration<double> duration = end - start;
+            T_decode[simd] += duration.count() / iterations;
+            compressedOk = compressedOk && (int)result.size() == numVertices;
+        }
+    }
+    cout << "Adjacency: " << rawBytes << " bytes raw, " << compressedBytes << " bytes compressed ("
+         << fixed << setprecision(2) << (double)rawBytes / compressedBytes << "x)" << endl;
+    cout << "Scalar decode DFS: " << setprecision(6) << T_decode[0] << " seconds"
+         << (compressedOk ? "" : " [INCOMPLETE]") << endl;
+    if (svb::haveSSSE3())
+        cout << "SSSE3 decode DFS:  " << setprecision(6) << T_decode[1] << " seconds" << endl;
+    else
+        cout << "SSSE3 not supported, SIMD run used the scalar decoder" << endl;
+    
+    // SIMD neighbor filtering on a graph with high-degree hubs
+    cout << "\n\n===========================================" << endl;
+    cout << "SIMD NEIGHBOR FILTERING" << endl;
+    cout << "===========================================" << endl;
+    const int hubDegree = 4000;
+    CSRGraph hubGraph(createHubGraph(numVertices, hubDegree));
+    vector<FilterKernel> kernels = {FilterKernel::Scalar, FilterKernel::AVX2, FilterKernel::AVX512};
+    vector<double> T_kernel(kernels.size(), 0), nsPerNeighbor(kernels.size(), 0);
+    vector<int> scalarOrder;
+    
+    // Half of all vertices visited, so the keep mask is unpredictable
+    VisitedBits halfVisited(numVertices);
+    for (int v = 0; v < numVertices; v += 2)
+        halfVisited.set(v);
+    vector<int> filtered(hubDegree + 8 + FILTER_SLACK);
+    
+    for (size_t k = 0; k < kernels.size(); k++) {
+        if (!filterKernelSupported(kernels[k])) {
+            cout << left << setw(8) << filterKernelName(kernels[k]) << "not supported on this CPU" << endl;
+            continue;
+        }
+        
+        NeighborFilter filter = neighborFilter(kernels[k]);
+        const int filterRounds = 200;
+        auto start = chrono::high_resolution_clock::now();
+        for (int round = 0; round < filterRounds; round++)
+            for (int h = 0; h < numVertices; h += 1000)
+                filter(hubGraph.begin(h), hubGraph.degree(h), halfVisited.data(), filtered.data());
+        auto end = chrono::high_resolution_clock::now();
+        chrono::duration<double> filterTime = end - start;
+        nsPerNeighbor[k] = filterTime.count() * 1e9 / (filterRounds * (numVertices / 1000) * (double)hubDegree);
+        
+        bool sameOrder = true;
+        for (int iter = 0; iter < iterations; iter++) {
+            DfsOptions options;
+            options.filter = kernels[k];
+            OrderCollector order;
+            start = chrono::high_resolution_clock::now();
+            dfsRun(Sequential(), hubGraph, order, options);
+            end = chrono::high_resolution_clock::now();
+            vector<int> result = order.order();
+            
+            chrono::duration<double> duration = end - start;
+            T_kernel[k] += duration.count() / iterations;
+            if (scalarOrder.empty())
+                scalarOrder = result;
+            sameOrder = sameOrder && result == scalarOrder;
+        }
+        cout << left << setw(8) << filterKernelName(kernels[k])
+             << "hub filter " << fixed << setprecision(3) << nsPerNeighbor[k] << " ns/neighbor, "
+             << "DFS " << setprecision(6) << T_kernel[k] << " seconds"
+             << (sameOrder ? "" : " [ORDER MISMATCH]") << endl;
+    }
+    
+    // Software prefetching: distance sweep on a graph far larger than cache
+    cout << "\n\n===========================================" << endl;
+    cout << "SOFTWARE PREFETCHING" << endl;
+    cout << "===========================================" << endl;
+    const int scatteredVertices = 4000000;
+    CSRGraph scattered(createScatteredGraph(scatteredVertices));
+    vector<int> prefetchDistances = {0, 4, 8, 16, 32, 64};
+    vector<double> T_prefetch;
+    size_t bestPrefetch = 0;
+    for (int distance : prefetchDistances) {
+        double sum = 0;
+        for (int iter = 0; iter < iterations; iter++) {
+            DfsOptions options;
+            options.prefetchDistance = distance;
+            OrderCollector order;
+            auto start = chrono::high_resolution_clock::now();
+            dfsRun(Sequential(), scattered, order, options);
+            auto end = chrono::high_resolution_clock::now();
+            
+            chrono::duration<double> duration = end - start;
+            sum += duration.count();
+        }
+        T_prefetch.push_back(sum / iterations);
+        cout << "Distance " << left << setw(4) << distance << fixed << setprecision(6) << T_prefetch.back()
+             << " seconds, speedup " << setprecision(4) << (T_prefetch[0] / T_prefetch.back())
+             << (distance == 0 ? " (prefetching off)" : "") << endl;
+    }
+    for (size_t i = 0; i < prefetchDistances.size(); i++)
+        if (T_prefetch[i] < T_prefetch[bestPrefetch])
+            bestPrefetch = i;
+    cout << "Best distance: " << prefetchDistances[bestPrefetch] << endl;
+    
+    // NUMA placement: pinned threads, first-touch vs interleaved graph arrays
+    cout << "\n\n===========================================" << endl;
+    cout << "NUMA PLACEMENT" << endl;
+    cout << "===========================================" << endl;
+    NumaTopology topology = NumaTopology::detect();
+    cout << "NUMA nodes: " << topology.numNodes();
+    if (topology.isSingleNode())
+        cout << " (single node, placement is uniform)";
+    cout << endl;
+    
+    vector<double> T_numa[2];
+    vector<double> remoteRatios[2];
+    for (int threads : threadCounts) {
+        ThreadPlacement placement(topology, threads);
+        for (NumaPolicy policy : {NumaPolicy::FirstTouch, NumaPolicy::Interleave}) {
+            int p = (int)policy;
+            NumaCSRGraph numaGraph(scattered, placement, topology, policy);
+            PlacementReport report = placementReport(numaGraph, placement);
+            StealStats steals;
+            
+            double sum = 0;
+            bool complete = true;
+            for (int iter = 0; iter < iterations; iter++) {
+                auto start = chrono::high_resolution_clock::now();
+                vector<int> result = dfsParallelNuma(numaGraph, placement, steals);
+                auto end = chrono::high_resolution_clock::now();
+                
+                chrono::duration<double> duration = end - start;
+                sum += duration.count();
+                complete = complete && (int)result.size() == scatteredVertices;
+            }
+            T_numa[p].push_back(sum / iterations);
+            remoteRatios[p].push_back(report.remoteRatio());
+            
+            cout << (policy == NumaPolicy::FirstTouch ? "First-touch " : "Interleave  ") << threads << " thread(s): "
+                 << fixed << setprecision(6) << T_numa[p].back() << " seconds, remote pages ";
+            if (report.remoteRatio() < 0)
+                cout << "unknown";
+            else
+                cout << setprecision(1) << (report.remoteRatio() * 100) << "%";
+            cout << ", steals " << steals.localSteals << " local / " << steals.remoteSteals << " remote"
+                 << (complete ? "" : " [INCOMPLETE]") << endl;
+        }
+    }
+    
+    // The scattered graph keeps every thread busy on its own range, so
+    // nobody steals there. On the skewed graph the threads owning the
+    // isolated vertices run dry early and steal from the first range.
+    CSRGraph skewed(createSkewedGraph(scatteredVertices));
+    vector<double> T_skewed;
+    vector<StealStats> skewedSteals;
+    for (int threads : threadCounts) {
+        ThreadPlacement placement(topology, threads);
+        NumaCSRGraph numaGraph(skewed, placement, topology, NumaPolicy::FirstTouch);
+        StealStats steals, total;
+        double sum = 0;
+        bool complete = true;
+        for (int iter = 0; iter < iterations; iter++) {
+            auto start = chrono::high_resolution_clock::now();
+            vector<int> result = dfsParallelNuma(numaGraph, placement, steals);
+            auto end = chrono::high_resolution_clock::now();
+            
+            chrono::duration<double> duration = end - start;
+            sum += duration.count();
+            complete = complete && (int)result.size() == scatteredVertices;
+            total.localSteals += steals.localSteals;
+            total.remoteSteals += steals.remoteSteals;
+        }
+        T_skewed.push_back(sum / iterations);
+        skewedSteals.push_back(total);
+        cout << "Skewed graph " << threads << " thread(s): " << fixed << setprecision(6) << T_skewed.back()
+             << " seconds, steals " << total.localSteals << " local / " << total.remoteSteals << " remote over "
+             << iterations << " runs" << (complete ? "" : " [INCOMPLETE]") << endl;
+    }
+    
+    // Arena allocation: the same two-pass CSR build and sequential DFS, with
+    // the graph arrays and the stack on the heap or in one bump allocator
+    cout << "\n\n===========================================" << endl;
+    cout << "ARENA ALLOCATION" << endl;
+    cout << "===========================================" << endl;
+    long long heapBefore = heapAllocationCount();
+    auto start = chrono::high_resolution_clock::now();
+    {
+        CSRGraph heapGraph;
+        heapGraph.assign(scatteredVertices, scatteredEdges(scatteredVertices));
+        OrderCollector order;
+        dfsRun(Sequential(), heapGraph, order);
+    }
+    auto end = chrono::high_resolution_clock::now();
+    chrono::duration<double> heapTime = end - start;
+    long long heapPathAllocations = heapAllocationCount() - heapBefore;
+    
+    Arena arena(HugePages::Transparent);
+    heapBefore = heapAllocationCount();
+    start = chrono::high_resolution_clock::now();
+    {
+        ArenaCSRGraph arenaGraph{ArenaAllocator<int>(arena)};
+        arenaGraph.assign(scatteredVertices, scatteredEdges(scatteredVertices));
+        Sequential inArena;
+        inArena.arena = &arena;
+        SequentialVisited visited(scatteredVertices);
+        OrderCollector order;
+        dfsRunWith(inArena, arenaGraph, visited, order);
+    }
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> arenaTime = end - start;
+    long long arenaPathAllocations = heapAllocationCount() - heapBefore;
+    
+    cout << "Heap build + DFS:  " << fixed << setprecision(6) << heapTime.count() << " seconds";
+    if (countingAllocations)
+        cout << ", " << heapPathAllocations << " heap allocations";
+    cout << endl;
+    cout << "Arena build + DFS: " << fixed << setprecision(6) << arenaTime.count() << " seconds, ";
+    if (countingAllocations)
+        cout << arenaPathAllocations << " heap allocations, ";
+    cout << arena.allocations() << " arena allocations in " << arena.systemAllocations() << " chunk(s), "
+         << hugePagesName(arena.backing()) << endl;
+    if (countingAllocations)
+        cout << "Allocations saved: " << (heapPathAllocations - arenaPathAllocations - arena.systemAllocations())
+             << endl;
+    else
+        cout << "(build with -DCOUNT_ALLOCATIONS to count heap allocations)" << endl;
+    
+    // Small queries on a large graph: fresh visited array vs reused context
+    cout << "\n\n===========================================" << endl;
+    cout << "REUSABLE TRAVERSAL CONTEXT" << endl;
+    cout << "===========================================" << endl;
+    // Clusters of 32 vertices, each a ring with one chord
+    const int clusterVertices = 4000000;
+    vector<vector<int>> clustered(clusterVertices);
+    for (int i = 0; i < clusterVertices; i++) {
+        int base = i - i % 32;
+        clustered[i].push_back(base + (i + 1) % 32);
+        clustered[i].push_back(base + (i + 7) % 32);
+    }
+    
+    const int numQueries = 2000;
+    long long reachedFresh = 0, reachedContext = 0;
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < numQueries; q++) {
+        int source = (int)((q * 2654435761LL) % clusterVertices);
+        vector<bool> visited(clustered.size(), false);
+        vector<int> res, stack = {source};
+        while (!stack.empty()) {
+            int v = stack.back();
+            stack.pop_back();
+            if (visited[v])
+                continue;
+            visited[v] = true;
+            res.push_back(v);
+            for (auto it = clustered[v].rbegin(); it != clustered[v].rend(); ++it)
+                if (!visited[*it])
+                    stack.push_back(*it);
+        }
+        reachedFresh += res.size();
+    }
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> freshTime = end - start;
+    
+    TraversalContext queryContext(clustered.size());
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < numQueries; q++) {
+        int source = (int)((q * 2654435761LL) % clusterVertices);
+        reachedContext += dfsFrom(clustered, source, queryContext).size();
+    }
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> contextTime = end - start;
+    
+    double freshLatency = freshTime.count() / numQueries * 1e6;
+    double contextLatency = contextTime.count() / numQueries * 1e6;
+    cout << "Graph: " << clusterVertices << " vertices, " << (double)reachedContext / numQueries
+         << " reached per query" << endl;
+    cout << "Fresh visited per query: " << fixed << setprecision(2) << freshLatency << " us/query" << endl;
+    cout << "Epoch-stamped context:   " << fixed << setprecision(2) << contextLatency << " us/query"
+         << ", speedup " << setprecision(1) << (freshLatency / contextLatency) << "x"
+         << (reachedFresh == reachedContext ? "" : " [MISMATCH]") << endl;
+    
+    // Lazy DFS: time to the first k vertices vs materializing the whole order
+    cout << "\n\n===========================================" << endl;
+    cout << "LAZY DFS ITERATOR" << endl;
+    cout << "===========================================" << endl;
+    const size_t lazyPrefix = 1000;
+    start = chrono::high_resolution_clock::now();
+    OrderCollector fullOrder;
+    dfsRun(Sequential(), scattered, fullOrder);
+    vector<int> materialized = fullOrder.order();
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> materializedTime = end - start;
+    
+    start = chrono::high_resolution_clock::now();
+    Generator<int> prefixGen = dfsLazy(scattered);
+    vector<int> prefix = takeFirst(prefixGen, lazyPrefix);
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> prefixTime = end - start;
+    
+    start = chrono::high_resolution_clock::now();
+    size_t lazyCount = 0;
+    bool lazyOk = equal(prefix.begin(), prefix.end(), materialized.begin());
+    for (int v : dfsLazy(scattered)) {
+        lazyOk = lazyOk && v == materialized[lazyCount];
+        lazyCount++;
+    }
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> lazyTime = end - start;
+    lazyOk = lazyOk && lazyCount == materialized.size();
+    
+    cout << "Materialized order:  " << fixed << setprecision(6) << materializedTime.count() << " seconds, "
+         << materialized.size() << " vertices" << endl;
+    cout << "Lazy full iteration: " << lazyTime.count() << " seconds"
+         << (lazyOk ? "" : " [ORDER MISMATCH]") << endl;
+    cout << "Lazy first " << lazyPrefix << ":    " << prefixTime.count() << " seconds ("
+         << setprecision(1) << materializedTime.count() / prefixTime.count() << "x sooner)" << endl;
+    
+    // Streaming output: text written after the traversal vs async binary sinks
+    cout << "\n\n===========================================" << endl;
+    cout << "STREAMING OUTPUT" << endl;
+    cout << "===========================================" << endl;
+    const string orderPath = "dfs_order.out";
+    start = chrono::high_resolution_clock::now();
+    {
+        OrderCollector textOrder;
+        dfsRun(Sequential(), scattered, textOrder);
+        ofstream textFile(orderPath);
+        for (int v : textOrder.order())
+            textFile << v << '\n';
+    }
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> textTime = end - start;
+    cout << "Text after traversal:  " << fixed << setprecision(6) << textTime.count() << " seconds" << endl;
+    
+    vector<OrderFormat> orderFormats = {OrderFormat::Binary, OrderFormat::DeltaVarint};
+    vector<double> T_stream;
+    vector<long long> streamBytes;
+    for (OrderFormat format : orderFormats) {
+        start = chrono::high_resolution_clock::now();
+        AsyncOrderWriter writer;
+        bool streamOk = writer.open(orderPath, format);
+        SinkVisitor<AsyncOrderWriter> sinkVisitor(writer);
+        dfsRun(Sequential(), scattered, sinkVisitor);
+        streamOk = writer.close() && streamOk;
+        end = chrono::high_resolution_clock::now();
+        chrono::duration<double> duration = end - start;
+        T_stream.push_back(duration.count());
+        streamBytes.push_back(writer.bytesWritten());
+        
+        vector<int> readBack;
+        streamOk = streamOk && readOrderFile(orderPath, readBack) && readBack == materialized;
+        cout << left << setw(23) << (string(orderFormatName(format)) + " streamed:") << right
+             << fixed << setprecision(6) << duration.count() << " seconds, "
+             << setprecision(2) << (double)writer.bytesWritten() / writer.verticesWritten() << " bytes/vertex, "
+             << writer.producerStalls() << " stalls" << (streamOk ? "" : " [MISMATCH]") << endl;
+    }
+    
+    // Work stealing streams through per-thread staging buffers; the file
+    // holds every vertex once, in chunks from whichever thread filled one
+    double T_sharedStream;
+    {
+        start = chrono::high_resolution_clock::now();
+        AsyncOrderWriter writer;
+        bool streamOk = writer.open(orderPath, OrderFormat::DeltaVarint);
+        SharedSinkVisitor<AsyncOrderWriter> sinkVisitor(writer);
+        WorkStealing policy;
+        policy.numThreads = omp_get_max_threads();
+        dfsRun(policy, scattered, sinkVisitor);
+        sinkVisitor.finish();
+        streamOk = writer.close() && streamOk;
+        end = chrono::high_resolution_clock::now();
+        chrono::duration<double> duration = end - start;
+        T_sharedStream = duration.count();
+        
+        vector<int> readBack;
+        streamOk = streamOk && readOrderFile(orderPath, readBack) && (int)readBack.size() == scatteredVertices;
+        sort(readBack.begin(), readBack.end());
+        for (int i = 0; streamOk && i < (int)readBack.size(); i++) {
+            streamOk = readBack[i] == i;
+        }
+        cout << "Work stealing streamed: " << fixed << setprecision(6) << T_sharedStream << " seconds, "
+             << policy.numThreads << " thread(s), " << writer.producerStalls() << " stalls"
+             << (streamOk ? "" : " [MISMATCH]") << endl;
+    }
+    remove(orderPath.c_str());
+    
+    // Incremental maintenance: repair tree labels per batch vs recompute them
+    cout << "\n\n===========================================" << endl;
+    cout << "INCREMENTAL MAINTENANCE" << endl;
+    cout << "===========================================" << endl;
+    const int dynamicVertices = 1000000;
+    const int numBatches = 10, batchEdges = 1000;
+    DynamicDfsForest forest(createScatteredGraph(dynamicVertices));
+    uint64_t updateState = 2463534242ULL;
+    auto nextRandom = [&]() {
+        updateState ^= updateState << 13;
+        updateState ^= updateState >> 7;
+        updateState ^= updateState << 17;
+        return updateState;
+    };
+    
+    double batchSeconds = 0;
+    IncrementalStats batchTotals;
+    for (int b = 0; b < numBatches; b++) {
+        EdgeBatch batch;
+        while ((int)batch.deletions.size() < batchEdges) {
+            int u = nextRandom() % dynamicVertices;
+            const vector<int> &outEdges = forest.graph()[u];
+            if (!outEdges.empty())
+                batch.deletions.push_back({u, outEdges[nextRandom() % outEdges.size()]});
+        }
+        for (int i = 0; i < batchEdges; i++)
+            batch.insertions.push_back({(int)(nextRandom() % dynamicVertices), (int)(nextRandom() % dynamicVertices)});
+        
+        start = chrono::high_resolution_clock::now();
+        IncrementalStats stats = forest.applyBatch(batch);
+        end = chrono::high_resolution_clock::now();
+        chrono::duration<double> duration = end - start;
+        batchSeconds += duration.count() / numBatches;
+        batchTotals.repairedVertices += stats.repairedVertices;
+        batchTotals.labelChanges += stats.labelChanges;
+    }
+    
+    start = chrono::high_resolution_clock::now();
+    vector<int> recomputed = dfsForestLabels(forest.graph());
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> recomputeTime = end - start;
+    
+    cout << "Graph: " << dynamicVertices << " vertices, batches of " << batchEdges << " deletions + "
+         << batchEdges << " insertions, " << forest.numTrees() << " trees" << endl;
+    cout << "Incremental batch: " << fixed << setprecision(6) << batchSeconds << " seconds, "
+         << batchTotals.repairedVertices / numBatches << " repaired, "
+         << batchTotals.labelChanges / numBatches << " label changes"
+         << (recomputed == forest.labels() ? "" : " [MISMATCH]") << endl;
+    cout << "Full recompute:    " << recomputeTime.count() << " seconds, speedup "
+         << setprecision(1) << recomputeTime.count() / batchSeconds << "x" << endl;
+    
+    // Versioned snapshots: queries keep running while a writer ingests batches
+    cout << "\n\n===========================================" << endl;
+    cout << "VERSIONED SNAPSHOTS" << endl;
+    cout << "===========================================" << endl;
+    const int ingestBatches = 50, queryLimit = 10000;
+    // expectedAdj receives every batch directly, to check the store against
+    vector<vector<int>> expectedAdj = createScatteredGraph(dynamicVertices);
+    VersionedGraph store(expectedAdj, 0.01);
+    atomic<bool> ingesting(true);
+    atomic<long long> queriesServed(0), inconsistentQueries(0);
+    double ingestSeconds = 0;
+    
+    // Bounded exploration, as an interactive query would do
+    struct QueryVisitor : DfsVisitor {
+        int limit, seen = 0;
+        long long checksum = 0;
+        explicit QueryVisitor(int limit) : limit(limit) {}
+        bool discover(int v) {
+            checksum = checksum * 31 + v;
+            return ++seen < limit;
+        }
+    };
+    
+    #pragma omp parallel num_threads(4)
+    {
+        if (omp_get_thread_num() == 0) {
+            auto ingestStart = chrono::high_resolution_clock::now();
+            for (int b = 0; b < ingestBatches; b++) {
+                EdgeBatch batch;
+                GraphSnapshot current = store.snapshot();
+                while ((int)batch.deletions.size() < batchEdges) {
+                    int u = nextRandom() % dynamicVertices;
+                    if (current.degree(u) > 0) {
+                        const int *first, *last;
+                        current.neighbors(u, first, last);
+                        batch.deletions.push_back({u, first[nextRandom() % (last - first)]});
+                    }
+                }
+                for (int i = 0; i < batchEdges; i++)
+                    batch.insertions.push_back({(int)(nextRandom() % dynamicVertices), (int)(nextRandom() % dynamicVertices)});
+                store.applyBatch(batch);
+                for (const pair<int, int> &edge : batch.deletions) {
+                    vector<int> &list = expectedAdj[edge.first];
+                    auto it = find(list.begin(), list.end(), edge.second);
+                    if (it != list.end())
+                        list.erase(it);
+                }
+                for (const pair<int, int> &edge : batch.insertions)
+                    expectedAdj[edge.first].push_back(edge.second);
+            }
+            ingestSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - ingestStart).count();
+            ingesting = false;
+        } else {
+            TraversalContext queryCtx(dynamicVertices);
+            vector<int> queryStack;
+            for (int q = omp_get_thread_num(); ingesting; q += 3) {
+                // The same query twice on one snapshot must agree
+                GraphSnapshot snap = store.snapshot();
+                int source = (int)((q * 2654435761LL) % dynamicVertices);
+                long long checksums[2];
+                for (int rep = 0; rep < 2; rep++) {
+                    queryCtx.begin(dynamicVertices);
+                    ContextVisited<false> visited(queryCtx);
+                    QueryVisitor query(queryLimit);
+                    dfsFromRoot(snap, source, visited, queryStack, query);
+                    checksums[rep] = query.checksum;
+                }
+                queriesServed++;
+                if (checksums[0] != checksums[1])
+                    inconsistentQueries++;
+            }
+        }
+    }
+    
+    // After a final compaction every list must match the directly applied one
+    size_t pendingDeltas = store.pendingDeltas();
+    store.compactNow();
+    bool storeExact = true;
+    {
+        GraphSnapshot compacted = store.snapshot();
+        for (int v = 0; v < dynamicVertices && storeExact; v++) {
+            const int *first, *last;
+            compacted.neighbors(v, first, last);
+            storeExact = equal(first, last, expectedAdj[v].begin(), expectedAdj[v].end());
+        }
+    }
+    VersionedGraphStats storeStats = store.stats();
+    
+    cout << "Ingest: " << ingestBatches << " batches in " << fixed << setprecision(6) << ingestSeconds
+         << " seconds, " << setprecision(2) << ingestSeconds / ingestBatches * 1000 << " ms/batch" << endl;
+    cout << "Queries served during ingest: " << queriesServed.load() << " (3 readers, " << queryLimit
+         << " vertices each)" << (inconsistentQueries.load() == 0 ? "" : " [INCONSISTENT]") << endl;
+    cout << "Versions: " << storeStats.versionsPublished << " published, " << storeStats.versionsFreed
+         << " freed, " << storeStats.compactions << " compaction(s), " << pendingDeltas
+         << " delta segment(s) pending after ingest" << endl;
+    cout << "Final store after compaction: " << (storeExact ? "matches" : "differs from")
+         << " the batches applied directly" << (storeExact ? "" : " [MISMATCH]") << endl;
+    
+    // Reachability cache: popular sources queried over and over
+    cout << "\n\n===========================================" << endl;
+    cout << "REACHABILITY CACHE" << endl;
+    cout << "===========================================" << endl;
+    const int cacheVertices = 1000000, communitySize = 10000;
+    const int popularSources = 5000, cacheQueries = 200000, uncachedQueries = 200, hubQueries = 100000;
+    const size_t cacheBudget = 16 << 20;
+    vector<vector<int>> communities(cacheVertices);
+    for (int i = 0; i < cacheVertices; i++) {
+        int base = i - i % communitySize;
+        for (int j = 0; j < 3; j++)
+            communities[i].push_back(base + (int)(nextRandom() % communitySize));
+    }
+    
+    // Source popularity follows Zipf's law over popularSources sources
+    vector<double> popularity(popularSources);
+    double totalPopularity = 0;
+    for (int r = 0; r < popularSources; r++) {
+        totalPopularity += 1.0 / (r + 1);
+        popularity[r] = totalPopularity;
+    }
+    auto sourceOfRank = [&](int rank) { return (int)((rank * 2654435761LL) % cacheVertices); };
+    auto popularSource = [&]() {
+        double x = (nextRandom() % 1000000) / 1e6 * totalPopularity;
+        return sourceOfRank(lower_bound(popularity.begin(), popularity.end(), x) - popularity.begin());
+    };
+    
+    // A zero budget admits nothing, so every query traverses
+    ReachCache uncached(communities, 0);
+    long long reachedTotal = 0;
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < uncachedQueries; q++)
+        reachedTotal += uncached.summary(communities, popularSource()).count;
+    end = chrono::high_resolution_clock::now();
+    double uncachedLatency = chrono::duration<double, micro>(end - start).count() / uncachedQueries;
+    
+    ReachCache cache(communities, cacheBudget);
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < cacheQueries; q++)
+        cache.summary(communities, popularSource());
+    end = chrono::high_resolution_clock::now();
+    double cachedLatency = chrono::duration<double, micro>(end - start).count() / cacheQueries;
+    ReachCacheStats cacheStats = cache.statistics();
+    
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < hubQueries; q++)
+        cache.summary(communities, sourceOfRank(q % 20));
+    end = chrono::high_resolution_clock::now();
+    double hubLatency = chrono::duration<double, micro>(end - start).count() / hubQueries;
+    
+    int reachableTargets = 0;
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < hubQueries; q++)
+        reachableTargets += cache.reaches(communities, popularSource(), (int)(nextRandom() % cacheVertices));
+    end = chrono::high_resolution_clock::now();
+    double reachLatency = chrono::duration<double, micro>(end - start).count() / hubQueries;
+    
+    // A small update batch; entries of untouched communities must survive
+    EdgeBatch cacheBatch;
+    while ((int)cacheBatch.deletions.size() < 25) {
+        int u = nextRandom() % cacheVertices;
+        if (!communities[u].empty()) {
+            int k = nextRandom() % communities[u].size();
+            cacheBatch.deletions.push_back({u, communities[u][k]});
+            communities[u].erase(communities[u].begin() + k);
+        }
+    }
+    for (int i = 0; i < 25; i++) {
+        int u = nextRandom() % cacheVertices;
+        int v = u - u % communitySize + (int)(nextRandom() % communitySize);
+        cacheBatch.insertions.push_back({u, v});
+        communities[u].push_back(v);
+    }
+    size_t entriesBefore = cache.entries();
+    int hotEntries = 0;
+    for (int source : cache.cachedSources())
+        hotEntries += cache.peek(source)->hasSet();
+    int dropped = cache.applyBatch(cacheBatch);
+    bool survivorsExact = true;
+    for (int source : cache.cachedSources())
+        survivorsExact = survivorsExact && cache.peek(source)->count == uncached.summary(communities, source).count;
+    
+    cout << "Graph: " << cacheVertices << " vertices in communities of " << communitySize << ", "
+         << popularSources << " Zipf-distributed sources, " << (cacheBudget >> 20) << " MB budget" << endl;
+    cout << "Uncached:      " << fixed << setprecision(2) << uncachedLatency << " us/query, "
+         << reachedTotal / uncachedQueries << " vertices reachable on average" << endl;
+    cout << "Cached:        " << cachedLatency << " us/query, hit rate " << setprecision(1)
+         << 100.0 * cacheStats.hits / (cacheStats.hits + cacheStats.misses) << "%, " << entriesBefore
+         << " entries (" << hotEntries << " with reachable sets)" << endl;
+    cout << "Hub sources:   " << setprecision(2) << hubLatency << " us/query, speedup " << setprecision(0)
+         << uncachedLatency / hubLatency << "x" << endl;
+    cout << "Reachability:  " << setprecision(2) << reachLatency << " us/query, " << reachableTargets
+         << " of " << hubQueries << " reachable" << endl;
+    cout << "Update batch:  " << cacheBatch.insertions.size() + cacheBatch.deletions.size() << " edges dropped "
+         << dropped << " of " << entriesBefore << " entries" << (survivorsExact ? "" : " [MISMATCH]") << endl;
+    
+    // Reachability index: random pairs on a DAG with long paths and some cycles
+    cout << "\n\n===========================================" << endl;
+    cout << "REACHABILITY INDEX" << endl;
+    cout << "===========================================" << endl;
+    const int indexVertices = 1000000, indexWindow = 1000, indexQueries = 1000000, dfsQueries = 200;
+    const string indexPath = "reach.idx";
+    vector<vector<int>> layered(indexVertices);
+    long long layeredEdges = 0;
+    for (int i = 0; i < indexVertices; i++) {
+        for (int j = 0; j < 2; j++) {
+            int v = i + 1 + (int)(nextRandom() % indexWindow);
+            if (v < indexVertices)
+                layered[i].push_back(v);
+        }
+    }
+    for (int i = 0; i < indexVertices; i += 100)
+        if (!layered[i].empty())
+            layered[layered[i][0]].push_back(i);
+    for (const vector<int> &list : layered)
+        layeredEdges += list.size();
+    
+    ReachabilityIndex reachIndex;
+    start = chrono::high_resolution_clock::now();
+    reachIndex.build(layered);
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> indexBuildTime = end - start;
+    
+    start = chrono::high_resolution_clock::now();
+    bool indexSaved = reachIndex.save(indexPath);
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> indexSaveTime = end - start;
+    ReachabilityIndex loadedIndex;
+    start = chrono::high_resolution_clock::now();
+    bool indexLoaded = indexSaved && loadedIndex.load(indexPath);
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double> indexLoadTime = end - start;
+    remove(indexPath.c_str());
+    
+    vector<pair<int, int>> reachPairs(indexQueries);
+    for (pair<int, int> &p : reachPairs)
+        p = {(int)(nextRandom() % indexVertices), (int)(nextRandom() % indexVertices)};
+    
+    TraversalContext indexCtx(indexVertices);
+    int indexPositives = 0;
+    start = chrono::high_resolution_clock::now();
+    for (const pair<int, int> &p : reachPairs)
+        indexPositives += reachIndex.reaches(p.first, p.second, indexCtx);
+    end = chrono::high_resolution_clock::now();
+    double indexLatency = chrono::duration<double, micro>(end - start).count() / indexQueries;
+    
+    long long answeredBy[4] = {0, 0, 0, 0};
+    bool indexAgrees = indexLoaded;
+    for (int q = 0; q < indexQueries; q++) {
+        const pair<int, int> &p = reachPairs[q];
+        answeredBy[(int)reachIndex.classify(p.first, p.second)]++;
+        if (indexLoaded && q % 10 == 0)
+            indexAgrees = indexAgrees && loadedIndex.reaches(p.first, p.second, indexCtx) ==
+                                             reachIndex.reaches(p.first, p.second, indexCtx);
+    }
+    
+    // Plain targeted DFS on the graph itself
+    struct TargetVisitor : DfsVisitor {
+        int target;
+        explicit TargetVisitor(int target) : target(target) {}
+        bool discover(int v) { return v != target; }
+    };
+    vector<char> dfsAnswers(dfsQueries);
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < dfsQueries; q++) {
+        indexCtx.begin(indexVertices);
+        ContextVisited<false> visited(indexCtx);
+        TargetVisitor search(reachPairs[q].second);
+        dfsAnswers[q] = dfsFromRoot(layered, reachPairs[q].first, visited, indexCtx.scratchStack(), search);
+    }
+    end = chrono::high_resolution_clock::now();
+    double searchLatency = chrono::duration<double, micro>(end - start).count() / dfsQueries;
+    for (int q = 0; q < dfsQueries; q++) {
+        const pair<int, int> &p = reachPairs[q];
+        indexAgrees = indexAgrees && (bool)dfsAnswers[q] == reachIndex.reaches(p.first, p.second, indexCtx);
+    }
+    
+    cout << "Graph: " << indexVertices << " vertices, " << layeredEdges << " edges, "
+         << reachIndex.numComponents() << " strongly connected components" << endl;
+    cout << "Build (" << omp_get_max_threads() << " threads): " << fixed << setprecision(6) << indexBuildTime.count()
+         << " seconds, " << reachIndex.numIntervals() << " intervals, " << setprecision(1)
+         << reachIndex.bytes() / 1048576.0 << " MB" << endl;
+    cout << "Save: " << setprecision(6) << indexSaveTime.count() << " seconds, load: " << indexLoadTime.count()
+         << " seconds" << (indexLoaded ? "" : " [LOAD FAILED]") << endl;
+    cout << "Index query: " << setprecision(3) << indexLatency << " us/query, " << indexPositives << " of "
+         << indexQueries << " reachable" << (indexAgrees ? "" : " [MISMATCH]") << endl;
+    cout << "Answered by labels: " << setprecision(1)
+         << 100.0 * (answeredBy[0] + answeredBy[1] + answeredBy[2]) / indexQueries << "% ("
+         << 100.0 * answeredBy[1] / indexQueries << "% topological order, "
+         << 100.0 * answeredBy[2] / indexQueries << "% intervals), searched "
+         << 100.0 * answeredBy[3] / indexQueries << "%" << endl;
+    cout << "DFS query:   " << setprecision(3) << searchLatency << " us/query, speedup " << setprecision(0)
+         << searchLatency / indexLatency << "x" << endl;
+    
+    // Path queries on a small-world graph
+    cout << "\n\n===========================================" << endl;
+    cout << "PATH SEARCH" << endl;
+    cout << "===========================================" << endl;
+    const int pathVertices = 1000000, pathQueries = 200;
+    CSRGraph smallWorld(createScatteredGraph(pathVertices));
+    CSRGraph smallWorldReverse = transposeGraph(smallWorld);
+    vector<pair<int, int>> pathPairs(pathQueries);
+    for (pair<int, int> &p : pathPairs)
+        p = {(int)(nextRandom() % pathVertices), (int)(nextRandom() % pathVertices)};
+    
+    // Baseline: the engine's one-sided target search, which finds no path
+    struct ExploringTarget : DfsVisitor {
+        int target;
+        long long explored = 0;
+        explicit ExploringTarget(int target) : target(target) {}
+        bool discover(int v) {
+            explored++;
+            return v != target;
+        }
+    };
+    TraversalContext pathCtx(pathVertices);
+    vector<char> targetFound(pathQueries);
+    long long targetExplored = 0;
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < pathQueries; q++) {
+        pathCtx.begin(pathVertices);
+        ContextVisited<false> visited(pathCtx);
+        ExploringTarget search(pathPairs[q].second);
+        targetFound[q] = dfsFromRoot(smallWorld, pathPairs[q].first, visited, pathCtx.scratchStack(), search);
+        targetExplored += search.explored;
+    }
+    end = chrono::high_resolution_clock::now();
+    double targetLatency = chrono::duration<double, micro>(end - start).count() / pathQueries;
+    
+    PathScratch pathScratch;
+    vector<vector<int>> serialPaths(pathQueries);
+    long long pathExplored[2] = {0, 0};
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < pathQueries; q++) {
+        bidirectionalPath(smallWorld, smallWorldReverse, pathPairs[q].first, pathPairs[q].second, pathScratch,
+                          serialPaths[q]);
+        pathExplored[0] += pathScratch.expanded;
+    }
+    end = chrono::high_resolution_clock::now();
+    double pathLatency[2];
+    pathLatency[0] = chrono::duration<double, micro>(end - start).count() / pathQueries;
+    
+    vector<int> parallelPath;
+    bool pathsAgree = true;
+    long long pathLengths = 0;
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < pathQueries; q++) {
+        bidirectionalPathParallel(smallWorld, smallWorldReverse, pathPairs[q].first, pathPairs[q].second,
+                                  pathScratch, parallelPath);
+        pathExplored[1] += pathScratch.expanded;
+        pathsAgree = pathsAgree && parallelPath.size() == serialPaths[q].size();
+    }
+    end = chrono::high_resolution_clock::now();
+    pathLatency[1] = chrono::duration<double, micro>(end - start).count() / pathQueries;
+    
+    // Every path must follow real edges from s to t, and exist exactly when
+    // the target search found t
+    for (int q = 0; q < pathQueries; q++) {
+        const vector<int> &path = serialPaths[q];
+        pathsAgree = pathsAgree && path.empty() == !targetFound[q];
+        if (path.empty())
+            continue;
+        pathLengths += path.size() - 1;
+        pathsAgree = pathsAgree && path.front() == pathPairs[q].first && path.back() == pathPairs[q].second;
+        for (size_t i = 0; i + 1 < path.size(); i++)
+            pathsAgree = pathsAgree && find(smallWorld.begin(path[i]), smallWorld.end(path[i]), path[i + 1]) !=
+                                           smallWorld.end(path[i]);
+    }
+    int pathsFound = count(targetFound.begin(), targetFound.end(), 1);
+    
+    cout << "Graph: " << pathVertices << " scattered vertices, " << pathQueries << " random pairs, "
+         << pathsFound << " connected, average path " << fixed << setprecision(1)
+         << (double)pathLengths / max(pathsFound, 1) << " edges" << endl;
+    cout << "DFS target search:      " << setprecision(2) << setw(10) << targetLatency << " us/query, "
+         << targetExplored / pathQueries << " vertices explored, no path" << endl;
+    cout << "Bidirectional serial:   " << setw(10) << pathLatency[0] << " us/query, "
+         << pathExplored[0] / pathQueries << " vertices expanded" << endl;
+    cout << "Bidirectional parallel: " << setw(10) << pathLatency[1] << " us/query, "
+         << pathExplored[1] / pathQueries << " vertices expanded (" << omp_get_max_threads() << " threads)"
+         << (pathsAgree ? "" : " [MISMATCH]") << endl;
+    
     // Save results to file
     ofstream resultsFile("performance_results.txt");
     if (resultsFile.is_open()) {
@@ -244,6 +1245,102 @@ int main()
                        << setw(15) << setprecision(4) << speedups[i]
                        << setw(15) << setprecision(4) << efficiencies[i] << "\n";
         }
+        
+        resultsFile << "\nTopological Sort (DAG, " << numVertices << " vertices)\n";
+        resultsFile << "Serial DFS postorder: " << fixed << setprecision(6) << T_topoSerial << " seconds\n";
+        for (size_t i = 0; i < threadCounts.size(); i++) {
+            resultsFile << "Parallel Kahn (" << threadCounts[i] << " threads): "
+                       << fixed << setprecision(6) << T_topoParallel[i] << " seconds\n";
+        }
+
+        resultsFile << "\nOut-of-core DFS (" << cacheBlocks << " of " << totalBlocks << " blocks cached)\n";
+        resultsFile << "Time: " << fixed << setprecision(6) << T_outOfCore << " seconds\n";
+        resultsFile << "Blocks read: " << blocksRead << ", deferred vertices: " << deferred << "\n";
+
+        resultsFile << "\nCompressed adjacency: " << rawBytes << " bytes raw, " << compressedBytes << " bytes compressed\n";
+        resultsFile << "Scalar decode DFS: " << fixed << setprecision(6) << T_decode[0] << " seconds\n";
+        resultsFile << "SIMD decode DFS: " << fixed << setprecision(6) << T_decode[1] << " seconds\n";
+
+        resultsFile << "\nSIMD neighbor filtering (hub degree " << hubDegree << ")\n";
+        for (size_t k = 0; k < kernels.size(); k++) {
+            if (filterKernelSupported(kernels[k]))
+                resultsFile << filterKernelName(kernels[k]) << ": " << fixed << setprecision(3) << nsPerNeighbor[k]
+                           << " ns/neighbor, DFS " << setprecision(6) << T_kernel[k] << " seconds\n";
+        }
+
+        resultsFile << "\nSoftware prefetching (" << scatteredVertices << " scattered vertices)\n";
+        for (size_t i = 0; i < prefetchDistances.size(); i++) {
+            resultsFile << "Distance " << prefetchDistances[i] << ": " << fixed << setprecision(6)
+                       << T_prefetch[i] << " seconds\n";
+        }
+        resultsFile << "Best distance: " << prefetchDistances[bestPrefetch] << "\n";
+
+        resultsFile << "\nArena allocation (" << hugePagesName(arena.backing()) << ")\n";
+        resultsFile << "Heap build + DFS: " << fixed << setprecision(6) << heapTime.count() << " seconds";
+        if (countingAllocations)
+            resultsFile << ", " << heapPathAllocations << " heap allocations";
+        resultsFile << "\nArena build + DFS: " << arenaTime.count() << " seconds, ";
+        if (countingAllocations)
+            resultsFile << arenaPathAllocations << " heap allocations, ";
+        resultsFile << arena.allocations() << " arena allocations\n";
+
+        resultsFile << "\nTraversal context (" << numQueries << " queries on " << clusterVertices << " vertices)\n";
+        resultsFile << "Fresh visited per query: " << fixed << setprecision(2) << freshLatency << " us/query\n";
+        resultsFile << "Epoch-stamped context: " << contextLatency << " us/query\n";
+
+        resultsFile << "\nLazy DFS iterator (" << scatteredVertices << " scattered vertices)\n";
+        resultsFile << "Materialized order: " << fixed << setprecision(6) << materializedTime.count() << " seconds\n";
+        resultsFile << "Lazy full iteration: " << lazyTime.count() << " seconds\n";
+        resultsFile << "Lazy first " << lazyPrefix << ": " << prefixTime.count() << " seconds\n";
+
+        resultsFile << "\nStreaming output (" << scatteredVertices << " vertices)\n";
+        resultsFile << "Text after traversal: " << fixed << setprecision(6) << textTime.count() << " seconds\n";
+        for (size_t i = 0; i < orderFormats.size(); i++) {
+            resultsFile << orderFormatName(orderFormats[i]) << " streamed: " << fixed << setprecision(6)
+                       << T_stream[i] << " seconds, " << streamBytes[i] << " bytes\n";
+        }
+        resultsFile << "Work stealing streamed: " << T_sharedStream << " seconds\n";
+
+        resultsFile << "\nIncremental maintenance (" << dynamicVertices << " vertices, " << batchEdges
+                   << " deletions + " << batchEdges << " insertions per batch)\n";
+        resultsFile << "Incremental batch: " << fixed << setprecision(6) << batchSeconds << " seconds\n";
+        resultsFile << "Full recompute: " << recomputeTime.count() << " seconds\n";
+
+        resultsFile << "\nVersioned snapshots (" << ingestBatches << " batches, 3 concurrent readers)\n";
+        resultsFile << "Ingest: " << fixed << setprecision(6) << ingestSeconds << " seconds, "
+                   << queriesServed.load() << " queries served during ingest, "
+                   << storeStats.compactions << " compaction(s)\n";
+
+        resultsFile << "\nReachability cache (" << popularSources << " sources, " << (cacheBudget >> 20) << " MB budget)\n";
+        resultsFile << "Uncached: " << fixed << setprecision(2) << uncachedLatency << " us/query\n";
+        resultsFile << "Cached: " << cachedLatency << " us/query, hub sources " << hubLatency << " us/query\n";
+        resultsFile << "Update batch dropped " << dropped << " of " << entriesBefore << " entries\n";
+
+        resultsFile << "\nReachability index (" << indexVertices << " vertices, " << reachIndex.numComponents()
+                   << " components)\n";
+        resultsFile << "Build: " << fixed << setprecision(6) << indexBuildTime.count() << " seconds\n";
+        resultsFile << "Index query: " << setprecision(3) << indexLatency << " us/query, DFS query: "
+                   << searchLatency << " us/query\n";
+
+        resultsFile << "\nPath search (" << pathVertices << " vertices, " << pathQueries << " queries)\n";
+        resultsFile << "DFS target search: " << fixed << setprecision(2) << targetLatency << " us/query\n";
+        resultsFile << "Bidirectional serial: " << pathLatency[0] << " us/query, parallel: " << pathLatency[1]
+                   << " us/query\n";
+
+        resultsFile << "\nNUMA placement (" << topology.numNodes() << " node(s))\n";
+        for (size_t i = 0; i < threadCounts.size(); i++) {
+            resultsFile << threadCounts[i] << " threads: first-touch " << fixed << setprecision(6) << T_numa[0][i]
+                       << " seconds, interleave " << T_numa[1][i] << " seconds";
+            if (remoteRatios[0][i] >= 0)
+                resultsFile << ", remote pages " << setprecision(1) << (remoteRatios[0][i] * 100) << "% / "
+                           << (remoteRatios[1][i] * 100) << "%";
+            resultsFile << "\n";
+        }
+        for (size_t i = 0; i < threadCounts.size(); i++) {
+            resultsFile << threadCounts[i] << " threads, skewed graph: " << fixed << setprecision(6) << T_skewed[i]
+                       << " seconds, steals " << skewedSteals[i].localSteals << " local / "
+                       << skewedSteals[i].remoteSteals << " remote\n";
+        }
         resultsFile.close();
         cout << "\nResults saved to performance_results.txt" << endl;
     }
@@ -0,0 +1,384 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include "dfs_engine.h"
+#include "incremental_dfs.h"
+
+// Memoized reachable-set summaries, in front of the traversal engines.
+//
+// A summary of source s holds how many vertices s reaches, the weak
+// component of s, and for hot sources the reachable set itself: a sorted
+// vertex list while that is smaller than a bitmap of numVertices bits, the
+// bitmap otherwise. A source is hot once the frequency sketch has seen it
+// hotThreshold times; cold summaries cost a few dozen bytes, hot ones
+// min(4 * count, numVertices / 8) more, and the budget is charged that.
+//
+// Entries live in an LRU list under a byte budget. Admission follows
+// TinyLFU: a new summary only displaces the least recently used entry if
+// its source was requested more often, per a count-min sketch whose
+// counters are halved periodically so past popularity fades. One-off
+// sources therefore cannot flush the hubs out of the cache.
+//
+// applyBatch drops exactly the entries a batch can affect:
+//
+//  - hot: an insertion u -> v matters if s reaches u but not v; a deletion
+//    u -> v if s reaches both. Other entries stay valid and exact.
+//  - cold: only the set is missing, so any edge whose tail lies in the
+//    weak component of s drops the entry.
+//
+// Weak components come from a union-find over the edges. Deletions never
+// split components there, so they may be coarser than the graph's, which
+// only costs precision, never correctness.
+//
+// The cache assumes every query passes the same graph, updated in step with
+// applyBatch. It is not thread-safe; use one per thread or guard it.
+
+struct ReachSummary {
+    int source = -1;
+    int count = 0;                // vertices reachable from source, itself included
+    int component = -1;           // smallest vertex of the weak component of source
+    std::vector<int> vertices;    // reachable set of a hot source, sorted, if smaller than the bitmap
+    std::vector<uint64_t> bitmap; // reachable set of a hot source otherwise
+
+    bool hasSet() const { return !vertices.empty() || !bitmap.empty(); }
+    bool contains(int v) const {
+        if (!bitmap.empty())
+            return (bitmap[v >> 6] >> (v & 63)) & 1;
+        return std::binary_search(vertices.begin(), vertices.end(), v);
+    }
+};
+
+struct ReachCacheStats {
+    long long hits = 0;
+    long long misses = 0;
+    long long traversals = 0;   // full or targeted searches run
+    long long rejected = 0;     // summaries TinyLFU refused to admit
+    long long evictions = 0;
+    long long invalidations = 0; // entries dropped by applyBatch
+    long long componentRejects = 0; // reaches() answered false by component
+};
+
+// Count-min sketch of access counts with 4-bit saturating counters.
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t width = 1024) {
+        size_t w = 64;
+        while (w < width)
+            w <<= 1;
+        mask = w - 1;
+        counters.assign(ROWS * w, 0);
+        sampleSize = 10 * w;
+    }
+
+    void record(int key) {
+        for (int row = 0; row < ROWS; row++)
+        {
+            uint8_t &c = counters[row * (mask + 1) + slot(key, row)];
+            if (c < 15)
+                c++;
+        }
+        if (++additions == sampleSize)
+            age();
+    }
+
+    int estimate(int key) const {
+        int best = 15;
+        for (int row = 0; row < ROWS; row++)
+            best = std::min<int>(best, counters[row * (mask + 1) + slot(key, row)]);
+        return best;
+    }
+
+private:
+    static const int ROWS = 4;
+
+    size_t slot(int key, int row) const {
+        uint64_t h = ((uint64_t)(uint32_t)key + (uint64_t)(row + 1) * 0x9E3779B97F4A7C15ULL) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+        return h & mask;
+    }
+
+    // Halves every counter, so the sketch tracks recent popularity.
+    void age() {
+        for (uint8_t &c : counters)
+            c >>= 1;
+        additions /= 2;
+    }
+
+    std::vector<uint8_t> counters;
+    size_t mask = 0;
+    size_t sampleSize = 0;
+    size_t additions = 0;
+};
+
+class ReachCache {
+public:
+    template <typename Graph>
+    ReachCache(const Graph &g, size_t budgetBytes, int hotThreshold = 4)
+        : n(GraphTraits<Graph>::numVertices(g)), budget(budgetBytes), hotThreshold(hotThreshold),
+          sketch(std::min<size_t>(std::max<size_t>(budgetBytes / 256, 1024), 1 << 20)), ctx(n) {
+        uf.resize(n);
+        for (int v = 0; v < n; v++)
+            uf[v] = v;
+        for (int u = 0; u < n; u++)
+            GraphTraits<Graph>::forEachNeighbor(g, u, [&](int v) { unite(u, v); });
+    }
+
+    // Summary of source, computing it on a miss. The reference stays valid
+    // until the next call that can change the cache.
+    template <typename Graph>
+    const ReachSummary &summary(const Graph &g, int source) {
+        sketch.record(source);
+        bool hot = sketch.estimate(source) >= hotThreshold;
+        auto it = index.find(source);
+        if (it != index.end())
+        {
+            ReachSummary &entry = *it->second;
+            lru.splice(lru.begin(), lru, it->second);
+            if (!hot || entry.hasSet() || bytesFor(true, entry.count) > budget)
+            {
+                stats.hits++;
+                return entry;
+            }
+            // Became hot: recompute with the set. The cold entry stays
+            // until the new one is admitted.
+        }
+        stats.misses++;
+        traverse(g, source, hot, scratch);
+        return admit();
+    }
+
+    // Whether source reaches target, from the cache when possible.
+    template <typename Graph>
+    bool reaches(const Graph &g, int source, int target) {
+        if (source == target)
+            return true;
+        if (find(source) != find(target))
+        {
+            stats.componentRejects++;
+            return false;
+        }
+        long long before = stats.traversals;
+        const ReachSummary &entry = summary(g, source);
+        if (entry.hasSet())
+            return entry.contains(target);
+        if (stats.traversals != before)
+            return ctx.isVisited(target); // just traversed from source
+
+        // Cold hit: search for the target alone.
+        struct TargetSearch : DfsVisitor {
+            int target;
+            explicit TargetSearch(int target) : target(target) {}
+            bool discover(int v) { return v != target; }
+        };
+        stats.traversals++;
+        ctx.begin(n);
+        ContextVisited<false> visited(ctx);
+        TargetSearch search(target);
+        return dfsFromRoot(g, source, visited, ctx.scratchStack(), search);
+    }
+
+    // Drops the entries an edge batch can change; call it when the batch is
+    // applied to the graph. Returns the number of entries dropped.
+    int applyBatch(const EdgeBatch &batch) {
+        std::unordered_map<int, std::vector<std::pair<int, int>>> insertions, deletions;
+        for (const std::pair<int, int> &e : batch.insertions)
+            insertions[find(e.first)].push_back(e);
+        for (const std::pair<int, int> &e : batch.deletions)
+            deletions[find(e.first)].push_back(e);
+
+        int dropped = 0;
+        for (auto it = lru.begin(); it != lru.end();)
+        {
+            const ReachSummary &entry = *it;
+            int c = find(entry.source);
+            bool stale = false;
+            auto ins = insertions.find(c);
+            auto del = deletions.find(c);
+            if (!entry.hasSet())
+            {
+                stale = ins != insertions.end() || del != deletions.end();
+            }
+            else
+            {
+                if (ins != insertions.end())
+                    for (const std::pair<int, int> &e : ins->second)
+                        stale = stale || (entry.contains(e.first) && !entry.contains(e.second));
+                if (del != deletions.end())
+                    for (const std::pair<int, int> &e : del->second)
+                        stale = stale || (entry.contains(e.first) && entry.contains(e.second));
+            }
+            if (stale)
+            {
+                used -= bytesFor(entry.hasSet(), entry.count);
+                index.erase(entry.source);
+                it = lru.erase(it);
+                dropped++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        for (const std::pair<int, int> &e : batch.insertions)
+            unite(e.first, e.second);
+        for (ReachSummary &entry : lru)
+            entry.component = find(entry.source);
+        stats.invalidations += dropped;
+        return dropped;
+    }
+
+    // The cached summary of source without touching recency or frequency;
+    // null if it is not cached.
+    const ReachSummary *peek(int source) const {
+        auto it = index.find(source);
+        return it == index.end() ? nullptr : &*it->second;
+    }
+
+    std::vector<int> cachedSources() const {
+        std::vector<int> sources;
+        for (const ReachSummary &entry : lru)
+            sources.push_back(entry.source);
+        return sources;
+    }
+
+    void clear() {
+        lru.clear();
+        index.clear();
+        used = 0;
+    }
+
+    int component(int v) { return find(v); }
+    size_t entries() const { return lru.size(); }
+    size_t bytesUsed() const { return used; }
+    const ReachCacheStats &statistics() const { return stats; }
+
+private:
+    typedef std::list<ReachSummary>::iterator Entry;
+
+    // Approximate footprint of one entry: summary, list node, index slot,
+    // and the reachable set in whichever form is smaller.
+    size_t bytesFor(bool withSet, int count) const {
+        size_t bytes = sizeof(ReachSummary) + 4 * sizeof(void *) + sizeof(std::pair<int, Entry>);
+        return withSet ? bytes + std::min((size_t)count * sizeof(int), bitmapBytes()) : bytes;
+    }
+
+    size_t bitmapBytes() const { return ((size_t)n + 63) / 64 * sizeof(uint64_t); }
+
+    int find(int v) {
+        while (uf[v] != v)
+        {
+            uf[v] = uf[uf[v]];
+            v = uf[v];
+        }
+        return v;
+    }
+
+    // The smaller root wins, so a component is named by its smallest vertex.
+    void unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a != b)
+            uf[std::max(a, b)] = std::min(a, b);
+    }
+
+    // Summary of source into out; with withSet, the reachable set is
+    // collected as a list and kept in the smaller of the two forms.
+    template <typename Graph>
+    void traverse(const Graph &g, int source, bool withSet, ReachSummary &out) {
+        struct Summarizer : DfsVisitor {
+            int count = 0;
+            std::vector<int> *reached;
+            explicit Summarizer(std::vector<int> *reached) : reached(reached) {}
+            bool discover(int v) {
+                count++;
+                if (reached)
+                    reached->push_back(v);
+                return true;
+            }
+        };
+
+        out.source = source;
+        out.component = find(source);
+        out.vertices.clear();
+        out.bitmap.clear();
+        stats.traversals++;
+        ctx.begin(n);
+        ContextVisited<false> visited(ctx);
+        Summarizer summarizer(withSet ? &out.vertices : nullptr);
+        dfsFromRoot(g, source, visited, ctx.scratchStack(), summarizer);
+        out.count = summarizer.count;
+
+        if (!withSet)
+            return;
+        if ((size_t)out.count * sizeof(int) < bitmapBytes())
+        {
+            std::sort(out.vertices.begin(), out.vertices.end());
+            out.vertices.shrink_to_fit();
+            return;
+        }
+        out.bitmap.assign(bitmapBytes() / sizeof(uint64_t), 0);
+        for (int v : out.vertices)
+            out.bitmap[v >> 6] |= 1ULL << (v & 63);
+        std::vector<int>().swap(out.vertices);
+    }
+
+    void remove(std::unordered_map<int, Entry>::iterator it) {
+        used -= bytesFor(it->second->hasSet(), it->second->count);
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    // Inserts scratch at the front if TinyLFU lets it displace enough of
+    // the least recently used entries; otherwise returns scratch itself. A
+    // cached entry of the same source is replaced only once scratch is
+    // admitted; the caller moves it to the front so it is never a victim.
+    const ReachSummary &admit() {
+        size_t cost = bytesFor(scratch.hasSet(), scratch.count);
+        if (cost > budget)
+        {
+            stats.rejected++;
+            return scratch;
+        }
+        auto replaced = index.find(scratch.source);
+        size_t freed = replaced == index.end() ? 0 : bytesFor(replaced->second->hasSet(), replaced->second->count);
+        int frequency = sketch.estimate(scratch.source);
+        while (used - freed + cost > budget)
+        {
+            const ReachSummary &victim = lru.back();
+            if (sketch.estimate(victim.source) >= frequency)
+            {
+                stats.rejected++;
+                return scratch;
+            }
+            stats.evictions++;
+            remove(index.find(victim.source));
+        }
+        if (replaced != index.end())
+            remove(replaced);
+        used += cost;
+        lru.push_front(std::move(scratch));
+        index[lru.front().source] = lru.begin();
+        scratch = ReachSummary();
+        return lru.front();
+    }
+
+    int n;
+    size_t budget;
+    int hotThreshold;
+    size_t used = 0;
+    std::list<ReachSummary> lru; // most recently used first
+    std::unordered_map<int, Entry> index;
+    FrequencySketch sketch;
+    std::vector<int> uf; // union-find parents of the weak components
+    ReachCacheStats stats;
+
+    // Scratch
+    TraversalContext ctx;
+    ReachSummary scratch;
+};
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "csr_graph.h"
+#include "dfs_engine.h"
+#include "traversal_context.h"
+
+// Reachability index from DFS intervals over the SCC condensation (GRAIL).
+//
+// Vertices in one strongly connected component reach each other, so the
+// index works on the condensation: one node per component, numbered in
+// topological order, and an edge between components wherever the graph has
+// one. Every u ~> v with different components has comp(u) < comp(v).
+//
+// Each of numIntervals randomized DFS traversals of the condensation labels
+// component c with an interval [low, post]: post is c's postorder rank and
+// low the smallest rank among everything c reaches. If c reaches d, d's
+// interval lies inside c's in every traversal, so a single interval that is
+// not nested proves d unreachable. Different traversals visit roots and
+// children in different orders, which makes a false nesting in all of them
+// unlikely. A query therefore only searches when every interval nests.
+// That search only follows components whose intervals still contain the
+// target's and whose number is not above it.
+//
+// Tarjan's algorithm finds the components serially; the labelings are
+// independent and run one per thread. Each thread writes its own column of
+// intervals, and the columns are interleaved per component afterwards, so
+// that threads never share cache lines and a query still reads one
+// component's intervals from one place.
+//
+// File layout: a ReachIndexFileHeader, the component of every vertex, the
+// condensation as CSR offsets and neighbors, then the intervals.
+
+enum class ReachAnswer {
+    SameComponent,    // reachable, no search needed
+    OrderRejected,    // unreachable: target component comes first
+    IntervalRejected, // unreachable: some interval does not nest
+    NeedsSearch,      // every interval nests; only a search can tell
+};
+
+struct ReachIndexFileHeader {
+    char magic[8];
+    int64_t numVertices;
+    int64_t numComponents;
+    int64_t numDagEdges;
+    int64_t numIntervals;
+};
+
+class ReachabilityIndex {
+public:
+    struct Interval {
+        int low;
+        int post;
+    };
+
+    template <typename Graph>
+    void build(const Graph &g, int numIntervals = 5, uint64_t seed = 1) {
+        k = std::max(numIntervals, 1);
+        condense(g);
+        std::vector<Interval> columns((size_t)k * nc);
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int i = 0; i < k; i++)
+            label(columns.data() + (size_t)i * nc, seed + i);
+
+        labels.resize((size_t)nc * k);
+        #pragma omp parallel for schedule(static)
+        for (int c = 0; c < nc; c++)
+            for (int i = 0; i < k; i++)
+                labels[(size_t)c * k + i] = columns[(size_t)i * nc + c];
+    }
+
+    int numVertices() const { return comp.size(); }
+    int numComponents() const { return nc; }
+    int numIntervals() const { return k; }
+    int component(int v) const { return comp[v]; }
+    const CSRGraph &condensation() const { return dag; }
+    size_t bytes() const {
+        return comp.size() * sizeof(int) + dag.offsets.size() * sizeof(int64_t) +
+               dag.neighbors.size() * sizeof(int) + labels.size() * sizeof(Interval);
+    }
+
+    // What the labels alone say about u ~> v.
+    ReachAnswer classify(int u, int v) const {
+        int cu = comp[u], cv = comp[v];
+        if (cu == cv)
+            return ReachAnswer::SameComponent;
+        if (cu > cv)
+            return ReachAnswer::OrderRejected;
+        return nests(cu, cv) ? ReachAnswer::NeedsSearch : ReachAnswer::IntervalRejected;
+    }
+
+    // Whether u reaches v; ctx is search scratch, one per thread.
+    bool reaches(int u, int v, TraversalContext &ctx) const {
+        ReachAnswer answer = classify(u, v);
+        if (answer != ReachAnswer::NeedsSearch)
+            return answer == ReachAnswer::SameComponent;
+        return search(comp[u], comp[v], ctx);
+    }
+
+    bool save(const std::string &path) const {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+
+        auto put = [&](const void *data, size_t size, size_t count) {
+            return count == 0 || fwrite(data, size, count, file) == count;
+        };
+        ReachIndexFileHeader header = {{'D', 'F', 'S', 'R', 'E', 'A', 'C', 'H'},
+                                       (int64_t)comp.size(), nc, dag.numEdges(), k};
+        bool ok = put(&header, sizeof(header), 1) && put(comp.data(), sizeof(int), comp.size()) &&
+                  put(dag.offsets.data(), sizeof(int64_t), dag.offsets.size()) &&
+                  put(dag.neighbors.data(), sizeof(int), dag.neighbors.size()) &&
+                  put(labels.data(), sizeof(Interval), labels.size());
+        return fclose(file) == 0 && ok;
+    }
+
+    // Loads an index written by save. Returns false on I/O failure or a
+    // malformed file: a component or condensation neighbor that is out of
+    // range, or condensation offsets that do not start at 0 or run backwards.
+    bool load(const std::string &path) {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+
+        auto get = [&](void *data, size_t size, size_t count) {
+            return count == 0 || fread(data, size, count, file) == count;
+        };
+        ReachIndexFileHeader header;
+        bool ok = get(&header, sizeof(header), 1) && memcmp(header.magic, "DFSREACH", 8) == 0 &&
+                  header.numVertices >= 0 && header.numComponents >= 0 && header.numDagEdges >= 0 &&
+                  header.numIntervals > 0 && header.numVertices < INT32_MAX && header.numComponents < INT32_MAX &&
+                  header.numIntervals < INT32_MAX;
+        if (ok)
+        {
+            comp.resize(header.numVertices);
+            dag.offsets.resize(header.numComponents + 1);
+            dag.neighbors.resize(header.numDagEdges);
+            labels.resize(header.numComponents * header.numIntervals);
+            ok = get(comp.data(), sizeof(int), comp.size()) &&
+                 get(dag.offsets.data(), sizeof(int64_t), dag.offsets.size()) &&
+                 get(dag.neighbors.data(), sizeof(int), dag.neighbors.size()) &&
+                 get(labels.data(), sizeof(Interval), labels.size()) && dag.offsets[0] == 0 &&
+                 dag.offsets.back() == header.numDagEdges;
+        }
+        for (size_t v = 0; ok && v < comp.size(); v++)
+            ok = comp[v] >= 0 && comp[v] < header.numComponents;
+        for (int64_t c = 0; ok && c < header.numComponents; c++)
+            ok = dag.offsets[c] <= dag.offsets[c + 1];
+        for (size_t e = 0; ok && e < dag.neighbors.size(); e++)
+            ok = dag.neighbors[e] >= 0 && dag.neighbors[e] < header.numComponents;
+        fclose(file);
+        nc = ok ? header.numComponents : 0;
+        k = ok ? header.numIntervals : 0;
+        return ok;
+    }
+
+private:
+    // Whether every interval of d lies inside the matching interval of c.
+    bool nests(int c, int d) const {
+        const Interval *a = &labels[(size_t)c * k];
+        const Interval *b = &labels[(size_t)d * k];
+        for (int i = 0; i < k; i++)
+            if (b[i].low < a[i].low || b[i].post > a[i].post)
+                return false;
+        return true;
+    }
+
+    // DFS over the condensation from cu, skipping components that cannot
+    // lead to cv.
+    bool search(int cu, int cv, TraversalContext &ctx) const {
+        ctx.begin(nc);
+        std::vector<int> &stack = ctx.scratchStack();
+        stack.push_back(cu);
+        ctx.markVisited(cu);
+        while (!stack.empty())
+        {
+            int c = stack.back();
+            stack.pop_back();
+            for (const int *it = dag.begin(c); it != dag.end(c); ++it)
+            {
+                int d = *it;
+                if (d == cv)
+                    return true;
+                if (d < cv && nests(d, cv) && ctx.markVisited(d))
+                    stack.push_back(d);
+            }
+        }
+        return false;
+    }
+
+    // Tarjan's algorithm, iterative. Components complete sinks first, so
+    // numbering them backwards gives a topological order.
+    template <typename Graph>
+    void condense(const Graph &g) {
+        int n = GraphTraits<Graph>::numVertices(g);
+        comp.assign(n, -1);
+        std::vector<int> index(n, -1), lowlink(n, 0);
+        std::vector<int> open; // vertices of unfinished components
+        std::vector<std::pair<int, const int *>> calls;
+        int counter = 0, completed = 0;
+
+        for (int root = 0; root < n; root++)
+        {
+            if (index[root] != -1)
+                continue;
+            index[root] = lowlink[root] = counter++;
+            open.push_back(root);
+            calls.push_back({root, GraphTraits<Graph>::neighborsBegin(g, root)});
+
+            while (!calls.empty())
+            {
+                int v = calls.back().first;
+                const int *&next = calls.back().second;
+                if (next != GraphTraits<Graph>::neighborsEnd(g, v))
+                {
+                    int w = *next++;
+                    if (index[w] == -1)
+                    {
+                        index[w] = lowlink[w] = counter++;
+                        open.push_back(w);
+                        calls.push_back({w, GraphTraits<Graph>::neighborsBegin(g, w)});
+                    }
+                    else if (comp[w] == -1)
+                    {
+                        lowlink[v] = std::min(lowlink[v], index[w]);
+                    }
+                    continue;
+                }
+
+                calls.pop_back();
+                if (!calls.empty())
+                {
+                    int parent = calls.back().first;
+                    lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+                }
+                if (lowlink[v] == index[v])
+                {
+                    int w;
+                    do
+                    {
+                        w = open.back();
+                        open.pop_back();
+                        comp[w] = completed;
+                    } while (w != v);
+                    completed++;
+                }
+            }
+        }
+
+        nc = completed;
+        #pragma omp parallel for schedule(static)
+        for (int v = 0; v < n; v++)
+            comp[v] = nc - 1 - comp[v];
+
+        // Condensation edges: count, fill, then drop duplicates per row.
+        std::vector<int64_t> rowStart(nc + 1, 0);
+        for (int v = 0; v < n; v++)
+            GraphTraits<Graph>::forEachNeighbor(g, v, [&](int w) {
+                if (comp[w] != comp[v])
+                    rowStart[comp[v] + 1]++;
+            });
+        for (int c = 0; c < nc; c++)
+            rowStart[c + 1] += rowStart[c];
+        std::vector<int> targets(rowStart[nc]);
+        std::vector<int64_t> fill(rowStart.begin(), rowStart.end() - 1);
+        for (int v = 0; v < n; v++)
+            GraphTraits<Graph>::forEachNeighbor(g, v, [&](int w) {
+                if (comp[w] != comp[v])
+                    targets[fill[comp[v]]++] = comp[w];
+            });
+
+        dag.offsets.assign(nc + 1, 0);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int c = 0; c < nc; c++)
+        {
+            int *first = targets.data() + rowStart[c];
+            int *last = targets.data() + rowStart[c + 1];
+            std::sort(first, last);
+            dag.offsets[c + 1] = std::unique(first, last) - first;
+        }
+        for (int c = 0; c < nc; c++)
+            dag.offsets[c + 1] += dag.offsets[c];
+        dag.neighbors.resize(dag.offsets[nc]);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int c = 0; c < nc; c++)
+            std::copy(targets.data() + rowStart[c], targets.data() + rowStart[c] + dag.degree(c),
+                      dag.neighbors.data() + dag.offsets[c]);
+    }
+
+    // One randomized postorder labeling into column, one interval per
+    // component: roots in shuffled order, children starting from a random
+    // position in each list.
+    void label(Interval *column, uint64_t seed) {
+        uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+        auto nextRandom = [&]() {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        };
+
+        std::vector<int> roots(nc);
+        for (int c = 0; c < nc; c++)
+            roots[c] = c;
+        for (int c = nc - 1; c > 0; c--)
+            std::swap(roots[c], roots[nextRandom() % (c + 1)]);
+
+        std::vector<char> visited(nc, 0);
+        std::vector<int> start(nc, 0);
+        std::vector<std::pair<int, int>> stack; // (component, children tried)
+        int rank = 0;
+        for (int root : roots)
+        {
+            if (visited[root])
+                continue;
+            visited[root] = 1;
+            stack.push_back({root, 0});
+            start[root] = dag.degree(root) > 0 ? nextRandom() % dag.degree(root) : 0;
+
+            while (!stack.empty())
+            {
+                int c = stack.back().first;
+                int &tried = stack.back().second;
+                int degree = dag.degree(c);
+                if (tried < degree)
+                {
+                    int d = dag.begin(c)[(start[c] + tried++) % degree];
+                    if (!visited[d])
+                    {
+                        visited[d] = 1;
+                        start[d] = dag.degree(d) > 0 ? nextRandom() % dag.degree(d) : 0;
+                        stack.push_back({d, 0});
+                    }
+                    continue;
+                }
+
+                // All children are finished: low is the smallest rank below.
+                Interval &mine = column[c];
+                mine.post = rank++;
+                mine.low = mine.post;
+                for (const int *it = dag.begin(c); it != dag.end(c); ++it)
+                    mine.low = std::min(mine.low, column[*it].low);
+                stack.pop_back();
+            }
+        }
+    }
+
+    std::vector<int> comp; // vertex -> component, in topological order
+    CSRGraph dag;          // condensation
+    std::vector<Interval> labels; // numIntervals per component, contiguous
+    int nc = 0;
+    int k = 0;
+};
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include "dfs_engine.h"
+
+// Streaming output of a traversal order.
+//
+// A sink is anything with emit(int v). SinkVisitor forwards each discovered
+// vertex to one, so an engine run streams its order instead of building a
+// vector first. VectorSink keeps it in memory; AsyncOrderWriter writes it
+// to a file.
+//
+// Sinks take one producer. Under the parallel policies SharedSinkVisitor
+// stages each thread's visits in a buffer of its own and hands full buffers
+// to the sink under a lock, so the sink sees chunks of chunkSize vertices
+// from one thread at a time, in the order the chunks filled up.
+//
+// AsyncOrderWriter encodes vertices into large buffers on the calling thread
+// and hands full buffers to a background thread that write()s them, so disk
+// I/O overlaps the traversal. At most maxBuffers full buffers wait in the
+// queue; a producer that gets that far ahead blocks until the writer
+// catches up, so memory stays at (maxBuffers + 2) * bufferBytes however long
+// the order is.
+//
+// File layout: an OrderFileHeader, then either raw 32-bit IDs (Binary) or,
+// for DeltaVarint, each ID as the zigzag-encoded difference from the
+// previous one in LEB128 varint form. DFS orders move mostly between nearby
+// IDs, so most records take one or two bytes.
+
+enum class OrderFormat { Binary = 0, DeltaVarint = 1 };
+
+inline const char *orderFormatName(OrderFormat format) {
+    return format == OrderFormat::Binary ? "binary" : "delta-varint";
+}
+
+struct OrderFileHeader {
+    char magic[8];
+    uint32_t format;
+    uint32_t reserved;
+};
+
+class VectorSink {
+public:
+    explicit VectorSink(std::vector<int> &out) : out(out) {}
+    void emit(int v) { out.push_back(v); }
+
+private:
+    std::vector<int> &out;
+};
+
+// For the Sequential policy. simulateWork as in OrderCollector.
+template <typename Sink>
+class SinkVisitor : public DfsVisitor {
+public:
+    explicit SinkVisitor(Sink &sink, bool simulateWork = false) : sink(sink), simulateWork(simulateWork) {}
+
+    bool discover(int v) {
+        sink.emit(v);
+        if (simulateWork)
+            simulatedWork(v);
+        return true;
+    }
+
+private:
+    Sink &sink;
+    bool simulateWork;
+};
+
+// For any policy; call finish() after the run to pass on what is staged.
+template <typename Sink>
+class SharedSinkVisitor : public DfsVisitor {
+public:
+    explicit SharedSinkVisitor(Sink &sink, bool simulateWork = false, size_t chunkSize = 4096)
+        : sink(sink), simulateWork(simulateWork), chunkSize(std::max<size_t>(chunkSize, 1)),
+          staged(engineMaxThreads()) {}
+
+    void beginTraversal(int numThreads) { staged.resize(std::max<size_t>(staged.size(), numThreads)); }
+
+    bool discover(int v) {
+        std::vector<int> &buffer = staged[engineThreadNum()];
+        buffer.push_back(v);
+        if (buffer.size() >= chunkSize)
+            flush(buffer);
+        if (simulateWork)
+            simulatedWork(v);
+        return true;
+    }
+
+    void finish() {
+        for (std::vector<int> &buffer : staged)
+            flush(buffer);
+    }
+
+private:
+    void flush(std::vector<int> &buffer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int v : buffer)
+            sink.emit(v);
+        buffer.clear();
+    }
+
+    Sink &sink;
+    bool simulateWork;
+    size_t chunkSize;
+    std::mutex mutex;
+    std::vector<std::vector<int>> staged; // per thread
+};
+
+class AsyncOrderWriter {
+public:
+    AsyncOrderWriter() = default;
+    AsyncOrderWriter(const AsyncOrderWriter &) = delete;
+    AsyncOrderWriter &operator=(const AsyncOrderWriter &) = delete;
+    ~AsyncOrderWriter() { close(); }
+
+    // Creates path and starts the writer thread. Returns false if the file
+    // cannot be created.
+    bool open(const std::string &path, OrderFormat format, size_t bufferBytes = 1 << 20, int maxBuffers = 4) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            return false;
+        this->format = format;
+        this->bufferBytes = std::max<size_t>(bufferBytes, 64);
+        this->maxBuffers = std::max(maxBuffers, 1);
+        previous = 0;
+        count = 0;
+        written = 0;
+        stalls = 0;
+        failed = false;
+        closing = false;
+
+        OrderFileHeader header;
+        memcpy(header.magic, "DFSORDER", 8);
+        header.format = (uint32_t)format;
+        header.reserved = 0;
+        current.resize(this->bufferBytes);
+        memcpy(current.data(), &header, sizeof(header));
+        used = sizeof(header);
+
+        worker = std::thread(&AsyncOrderWriter::writerLoop, this);
+        return true;
+    }
+
+    void emit(int v) {
+        if (used + MAX_RECORD > current.size())
+            submit();
+        uint8_t *out = current.data() + used;
+        if (format == OrderFormat::Binary)
+        {
+            memcpy(out, &v, sizeof(int));
+            used += sizeof(int);
+        }
+        else
+        {
+            int64_t delta = (int64_t)v - previous;
+            uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+            while (zigzag >= 0x80)
+            {
+                *out++ = (uint8_t)(zigzag | 0x80);
+                zigzag >>= 7;
+                used++;
+            }
+            *out = (uint8_t)zigzag;
+            used++;
+            previous = v;
+        }
+        count++;
+    }
+
+    // Flushes what is buffered, waits for the writer and closes the file.
+    // Returns false if any write failed.
+    bool close() {
+        if (fd < 0)
+            return !failed;
+        if (used > 0)
+            submit();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        changed.notify_all();
+        worker.join();
+        failed = ::close(fd) != 0 || failed;
+        fd = -1;
+        return !failed;
+    }
+
+    long long verticesWritten() const { return count; }
+    long long bytesWritten() const { return written; }
+    long long producerStalls() const { return stalls; } // times emit waited for the writer
+
+private:
+    static const size_t MAX_RECORD = 5; // a 33-bit zigzag delta as a varint
+
+    // Queues the current buffer, waiting while the queue is full.
+    void submit() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if ((int)queue.size() >= maxBuffers)
+        {
+            stalls++;
+            changed.wait(lock, [&] { return (int)queue.size() < maxBuffers; });
+        }
+        current.resize(used);
+        queue.push_back(std::move(current));
+        if (!spare.empty())
+        {
+            current = std::move(spare.back());
+            spare.pop_back();
+        }
+        else
+        {
+            current = std::vector<uint8_t>();
+        }
+        lock.unlock();
+        changed.notify_all();
+
+        current.resize(bufferBytes);
+        used = 0;
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            changed.wait(lock, [&] { return !queue.empty() || closing; });
+            if (queue.empty())
+                return;
+            std::vector<uint8_t> buffer = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            changed.notify_all();
+
+            size_t done = 0;
+            while (done < buffer.size() && !failed)
+            {
+                ssize_t got = write(fd, buffer.data() + done, buffer.size() - done);
+                if (got <= 0)
+                    failed = true;
+                else
+                    done += got;
+            }
+
+            lock.lock();
+            written += done;
+            if (spare.size() < 2)
+                spare.push_back(std::move(buffer));
+        }
+    }
+
+    int fd = -1;
+    OrderFormat format = OrderFormat::Binary;
+    size_t bufferBytes = 0;
+    int maxBuffers = 0;
+
+    // Producer side
+    std::vector<uint8_t> current;
+    size_t used = 0;
+    int previous = 0;
+    long long count = 0;
+    long long stalls = 0;
+
+    // Shared with the writer, under mutex
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> queue;
+    std::vector<std::vector<uint8_t>> spare;
+    bool closing = false;
+    bool failed = false;
+    long long written = 0;
+    std::thread worker;
+};
+
+// Reads a file written by AsyncOrderWriter. Returns false on I/O failure or
+// a malformed file.
+inline bool readOrderFile(const std::string &path, std::vector<int> &order) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[1 << 16];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        bytes.insert(bytes.end(), chunk, chunk + got);
+    fclose(file);
+
+    OrderFileHeader header;
+    if (bytes.size() < sizeof(header))
+        return false;
+    memcpy(&header, bytes.data(), sizeof(header));
+    if (memcmp(header.magic, "DFSORDER", 8) != 0)
+        return false;
+
+    order.clear();
+    size_t pos = sizeof(header);
+    if (header.format == (uint32_t)OrderFormat::Binary)
+    {
+        if ((bytes.size() - pos) % sizeof(int) != 0)
+            return false;
+        order.resize((bytes.size() - pos) / sizeof(int));
+        memcpy(order.data(), bytes.data() + pos, order.size() * sizeof(int));
+        return true;
+    }
+    if (header.format != (uint32_t)OrderFormat::DeltaVarint)
+        return false;
+
+    int64_t previous = 0;
+    while (pos < bytes.size())
+    {
+        uint64_t zigzag = 0;
+        int shift = 0;
+        uint8_t byte;
+        do
+        {
+            if (pos == bytes.size() || shift > 63)
+                return false;
+            byte = bytes[pos++];
+            zigzag |= (uint64_t)(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+        previous += delta;
+        order.push_back((int)previous);
+    }
+    return true;
+}
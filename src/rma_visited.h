@@ -0,0 +1,96 @@
+#pragma once
+
+#include <mpi.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <utility>
+
+// Visited bitmap of every rank's partition exposed through an MPI window.
+//
+// Any rank can claim any vertex with one MPI_Fetch_and_op(MPI_BOR) on the
+// owner's bitmap word under passive-target locking: the claim succeeds for
+// exactly one caller, whoever flipped the bit.
+//
+// The owner claims its own vertices with the same RMA call on its own
+// window. MPI makes accumulate operations atomic only with respect to each
+// other, not to processor atomics on the window memory, even in the unified
+// memory model, so a local fetch-or could race a remote one and both would
+// win. Vertices no other rank has an edge to cannot be claimed remotely:
+// when the constructor is told which vertices other ranks can reach,
+// claimLocal() accepts the others without touching the window, and the
+// caller's own visited flags keep them from being claimed twice.
+// attempted() and won() count remote claims only. Construction, reset() and
+// destruction are collective.
+class RmaVisitedWindow {
+public:
+    // remoteReachable[i] is nonzero if another rank has an edge to local
+    // vertex i; empty means every vertex may be claimed remotely.
+    RmaVisitedWindow(MPI_Comm comm, int localSize, std::vector<char> remoteReachable = {})
+        : comm(comm), remoteReachable(std::move(remoteReachable)) {
+        MPI_Comm_rank(comm, &rank);
+        numWords = (localSize + 63) / 64;
+        MPI_Win_allocate(numWords * sizeof(uint64_t) + sizeof(uint64_t), sizeof(uint64_t),
+                         MPI_INFO_NULL, comm, &words, &win);
+        memset(words, 0, numWords * sizeof(uint64_t));
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+        MPI_Barrier(comm);
+    }
+
+    ~RmaVisitedWindow() {
+        MPI_Win_unlock_all(win);
+        MPI_Win_free(&win);
+    }
+
+    RmaVisitedWindow(const RmaVisitedWindow &) = delete;
+    RmaVisitedWindow &operator=(const RmaVisitedWindow &) = delete;
+
+    // Clears this rank's bitmap. The barriers keep claims from the previous
+    // and the next traversal out of the window while it is rewritten.
+    void reset() {
+        MPI_Barrier(comm);
+        memset(words, 0, numWords * sizeof(uint64_t));
+        MPI_Win_sync(win);
+        MPI_Barrier(comm);
+        claimsAttempted = 0;
+        claimsWon = 0;
+    }
+
+    // True if this call marked vertex `localIndex` of `ownerRank` visited.
+    bool claim(int ownerRank, int localIndex) {
+        bool won = fetchOr(ownerRank, localIndex);
+        claimsAttempted++;
+        if (won)
+            claimsWon++;
+        return won;
+    }
+
+    // claim() for a vertex this rank owns. Always true for a vertex no other
+    // rank can reach; the caller must not claim those twice.
+    bool claimLocal(int localIndex) {
+        if (!remoteReachable.empty() && !remoteReachable[localIndex])
+            return true;
+        return fetchOr(rank, localIndex);
+    }
+
+    long long attempted() const { return claimsAttempted; }
+    long long won() const { return claimsWon; }
+
+private:
+    bool fetchOr(int ownerRank, int localIndex) {
+        uint64_t bit = 1ULL << (localIndex & 63);
+        uint64_t old;
+        MPI_Fetch_and_op(&bit, &old, MPI_UINT64_T, ownerRank, localIndex >> 6, MPI_BOR, win);
+        MPI_Win_flush(ownerRank, win);
+        return (old & bit) == 0;
+    }
+
+    MPI_Comm comm;
+    MPI_Win win;
+    uint64_t *words = nullptr;
+    int numWords = 0;
+    int rank = 0;
+    std::vector<char> remoteReachable;
+    long long claimsAttempted = 0;
+    long long claimsWon = 0;
+};
@@ -1,58 +1,75 @@
 #include <iostream>
 #include <vector>
+#include <string>
+#include <cstring>
 #include <ctime>
+#include "dfs_engine.h"
+#include "arena.h"
+#include "result_sink.h"
 using namespace std;
 
-void dfsRec(vector<vector<int>> &adj, vector<bool> &visited, int s, vector<int> &res, int stride) {
-    visited[s] = true;
-    res.push_back(s);
+// Records the visit order in an arena-backed buffer.
+struct ArenaOrder : DfsVisitor {
+    ArenaVector<int> order;
 
-    double work = 0;
-    for (int i = 0; i < 1000; i++)
-    {
-        work += (s * i) % 100;
-    }
+    explicit ArenaOrder(Arena &arena) : order(ArenaAllocator<int>(arena)) {}
 
-    for (int idx = 0; idx < adj[s].size(); idx += stride)
-    {
-        int i = adj[s][idx];
-        if (visited[i] == false)
-            dfsRec(adj, visited, i, res, stride);
-    }
-    
-    for (int idx = 0; idx < adj[s].size(); idx++)
-    {
-        if (idx % stride != 0)
-        {
-            int i = adj[s][idx];
-            if (visited[i] == false)
-                dfsRec(adj, visited, i, res, stride);
-        }
+    bool discover(int v) {
+        order.push_back(v);
+        simulatedWork(v);
+        return true;
     }
+};
+
+// Stack and result come from scratch; the caller resets it between runs.
+ArenaVector<int> dfs(const ArenaCSRGraph &graph, int stride, Arena &scratch) {
+    Sequential policy;
+    policy.arena = &scratch;
+    SequentialVisited visited(graph.size());
+    ArenaOrder visitor(scratch);
+    DfsOptions options;
+    options.stride = stride;
+    dfsRunWith(policy, graph, visited, visitor, options);
+    return std::move(visitor.order);
 }
 
-vector<int> dfs(vector<vector<int>> &adj, int stride) {
-    vector<bool> visited(adj.size(), false);
-    vector<int> res;
+// Streams the order to path instead of keeping it; the stack still comes
+// from scratch. Returns the number of vertices written, or -1 if the file
+// cannot be written.
+long long dfsToFile(const ArenaCSRGraph &graph, int stride, Arena &scratch, const string &path) {
+    AsyncOrderWriter writer;
+    if (!writer.open(path, OrderFormat::DeltaVarint))
+        return -1;
+    Sequential policy;
+    policy.arena = &scratch;
+    SequentialVisited visited(graph.size());
+    SinkVisitor<AsyncOrderWriter> visitor(writer, true);
+    DfsOptions options;
+    options.stride = stride;
+    dfsRunWith(policy, graph, visited, visitor, options);
+    return writer.close() ? writer.verticesWritten() : -1;
+}
 
-    for (int i = 0; i < adj.size(); i++)
+int main(int argc, char **argv)
+{
+    // --output=PATH writes each run's order to PATH.stride<N> (see
+    // result_sink.h for the format) instead of printing its start
+    string outputPath;
+    for (int i = 1; i < argc; i++)
     {
-        if (visited[i] == false)
+        if (strncmp(argv[i], "--output=", 9) == 0)
         {
-            dfsRec(adj, visited, i, res, stride);
+            outputPath = argv[i] + 9;
         }
     }
-    return res;
-}
 
-int main()
-{
     int numVertices = 50000;
-    vector<vector<int>> adj(numVertices);
+    Arena arena;
+    ArenaCSRGraph graph{ArenaAllocator<int>(arena)};
 
     cout << "Creating large graph with " << numVertices << " vertices..." << endl;
 
-    for (int i = 0; i < numVertices; i++)
+    graph.assign(numVertices, [&](int i, auto emit)
     {
         int connections = 2 + (i % 3);
         for (int j = 1; j <= connections; j++)
@@ -60,10 +77,10 @@ int main()
             int neighbor = (i * 7 + j * 13) % numVertices;
             if (neighbor != i)
             {
-                adj[i].push_back(neighbor);
+                emit(neighbor);
             }
         }
-    }
+    });
 
     cout << "Graph created successfully!" << endl;
 
@@ -76,22 +93,46 @@ int main()
         cout << "DFS Traversal of the graph (Serial):" << endl;
         cout << "Stride size: " << stride << endl;
 
+        Arena scratch;
+        string path = outputPath + ".stride" + to_string(stride);
         clock_t start = clock();
 
-        vector<int> result = dfs(adj, stride);
+        ArenaVector<int> result{ArenaAllocator<int>(scratch)};
+        long long written = 0;
+        if (outputPath.empty())
+        {
+            result = dfs(graph, stride, scratch);
+        }
+        else
+        {
+            written = dfsToFile(graph, stride, scratch, path);
+        }
 
         clock_t end = clock();
 
         double time_seconds = double(end - start) / CLOCKS_PER_SEC;
         double time_ms = time_seconds * 1000.0;
 
-        cout << "Total vertices visited: " << result.size() << endl;
-        cout << "First 10 vertices: ";
-        for (int i = 0; i < 10 && i < result.size(); i++)
+        if (outputPath.empty())
+        {
+            cout << "Total vertices visited: " << result.size() << endl;
+            cout << "First 10 vertices: ";
+            for (int i = 0; i < 10 && i < result.size(); i++)
+            {
+                cout << result[i] << " ";
+            }
+            cout << "..." << endl;
+        }
+        else if (written < 0)
+        {
+            cerr << "Could not write " << path << endl;
+            return 1;
+        }
+        else
         {
-            cout << result[i] << " ";
+            cout << "Total vertices visited: " << written << endl;
+            cout << "Order written to " << path << endl;
         }
-        cout << "..." << endl;
         cout << "Execution time: " << time_ms << " milliseconds (ms)" << endl;
         cout << endl;
     }
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Wire protocol of dfs_server, shared with its clients.
+//
+// A client connects to the server's Unix domain socket and writes
+// fixed-size QueryRequests back to back; it need not wait for an answer
+// before sending the next one. Each request gets one QueryResponseHeader
+// followed by count 32-bit values. Responses can arrive in a different
+// order than the requests; the id field pairs them up. Integers are in host
+// byte order, since both ends run on the same machine.
+//
+//   Info   values: numVertices, numEdges (low 32 bits), numEdges (high)
+//   Dfs    vertices reachable from source in DFS order, at most limit of
+//          them (0 means no limit)
+//   Reach  one value: 1 if target is reachable from source, else 0
+//   Path   a shortest path source ... target, empty if there is none
+
+enum class QueryOp : uint8_t { Info = 0, Dfs = 1, Reach = 2, Path = 3 };
+
+enum class QueryStatus : uint8_t { Ok = 0, BadRequest = 1 };
+
+struct QueryRequest {
+    uint32_t id;
+    uint8_t op;
+    uint8_t reserved[3];
+    int32_t source;
+    int32_t target;
+    uint32_t limit;
+};
+
+struct QueryResponseHeader {
+    uint32_t id;
+    uint8_t status;
+    uint8_t reserved[3];
+    uint32_t count;
+};
+
+inline QueryRequest makeRequest(uint32_t id, QueryOp op, int source = 0, int target = 0, uint32_t limit = 0) {
+    QueryRequest request;
+    memset(&request, 0, sizeof(request));
+    request.id = id;
+    request.op = (uint8_t)op;
+    request.source = source;
+    request.target = target;
+    request.limit = limit;
+    return request;
+}
+
+// Reads exactly bytes; false on EOF or error.
+inline bool readFull(int fd, void *data, size_t bytes) {
+    size_t done = 0;
+    while (done < bytes)
+    {
+        ssize_t got = read(fd, (char *)data + done, bytes - done);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return false;
+        done += got;
+    }
+    return true;
+}
+
+// Writes exactly bytes; a closed peer is an error, not a SIGPIPE.
+inline bool writeFull(int fd, const void *data, size_t bytes) {
+    size_t done = 0;
+    while (done < bytes)
+    {
+        ssize_t sent = send(fd, (const char *)data + done, bytes - done, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        done += sent;
+    }
+    return true;
+}
+
+inline bool socketAddress(const std::string &path, sockaddr_un &addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        return false;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Connects to a server; returns the socket or -1.
+inline int connectToServer(const std::string &path) {
+    sockaddr_un addr;
+    if (!socketAddress(path, addr))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (const sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads one response; false if the connection ended.
+inline bool readResponse(int fd, QueryResponseHeader &header, std::vector<int> &values) {
+    if (!readFull(fd, &header, sizeof(header)))
+        return false;
+    values.resize(header.count);
+    return header.count == 0 || readFull(fd, values.data(), header.count * sizeof(int));
+}
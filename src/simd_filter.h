@@ -0,0 +1,320 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "csr_graph.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Vectorized neighbor filtering for the traversal hot loop.
+//
+// A filter kernel takes a block of neighbor IDs, looks up each one in the
+// visited set and writes the unvisited ones, in order, to out. The scalar
+// kernel does it without a data-dependent branch; the AVX2 kernel gathers
+// eight lookups at a time and compacts through a permutation table; the
+// AVX-512 kernel gathers sixteen and uses a compress store. Kernels are
+// compiled with target attributes and picked at runtime, so the binary still
+// runs on machines without AVX.
+//
+// Every visited set of the engine has a kernel family: one bit per vertex
+// (VisitedBits, BitmapVisited), one byte per vertex (SequentialVisited,
+// AtomicVisited) and one 32-bit epoch stamp per vertex (TraversalContext).
+// A VisitedView names the layout and filterNeighbors dispatches on it; the
+// engine calls it from pushNeighbors.
+
+// Visited flags packed into 32-bit words, the gather width of the kernels.
+class VisitedBits {
+public:
+    explicit VisitedBits(int n = 0) : words((n + 31) / 32, 0) {}
+
+    bool test(int v) const { return (words[v >> 5] >> (v & 31)) & 1; }
+    void set(int v) { words[v >> 5] |= 1u << (v & 31); }
+    void clear() { std::fill(words.begin(), words.end(), 0); }
+    const uint32_t *data() const { return words.data(); }
+
+private:
+    std::vector<uint32_t> words;
+};
+
+// Read-only description of a visited set for the kernels. Byte flags are
+// gathered as the aligned 32-bit word that holds them, so the array must be
+// 4-byte aligned and readable up to the next multiple of 4; an unaligned
+// array falls back to the scalar kernel.
+struct VisitedView {
+    enum Layout { Bits, Bytes, Stamps };
+    Layout layout;
+    const void *data;
+    uint32_t epoch; // Stamps: the value that means visited
+
+    static VisitedView bits(const uint32_t *words) { return {Bits, words, 0}; }
+    static VisitedView bytes(const char *flags) { return {Bytes, flags, 0}; }
+    static VisitedView stamps(const uint32_t *stamp, uint32_t epoch) { return {Stamps, stamp, epoch}; }
+};
+
+// out must have room for count + FILTER_SLACK entries: the AVX2 kernel
+// stores whole vectors past the last kept ID.
+const int FILTER_SLACK = 16;
+
+typedef size_t (*NeighborFilter)(const int *ids, size_t count, const uint32_t *bits, int *out);
+
+inline size_t filterUnvisitedScalar(const int *ids, size_t count, const uint32_t *bits, int *out) {
+    size_t k = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        int u = ids[i];
+        out[k] = u;
+        k += ((bits[u >> 5] >> (u & 31)) & 1) ^ 1;
+    }
+    return k;
+}
+
+inline size_t filterUnvisitedBytesScalar(const int *ids, size_t count, const char *flags, int *out) {
+    size_t k = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        int u = ids[i];
+        out[k] = u;
+        k += flags[u] == 0;
+    }
+    return k;
+}
+
+inline size_t filterUnstampedScalar(const int *ids, size_t count, const uint32_t *stamp, uint32_t epoch, int *out) {
+    size_t k = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        int u = ids[i];
+        out[k] = u;
+        k += stamp[u] != epoch;
+    }
+    return k;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// keep-mask -> lane indices moving the kept lanes to the front
+struct CompactTable {
+    alignas(32) uint32_t indices[256][8];
+
+    CompactTable() {
+        for (int mask = 0; mask < 256; mask++)
+        {
+            int k = 0;
+            for (int lane = 0; lane < 8; lane++)
+                if (mask & (1 << lane))
+                    indices[mask][k++] = lane;
+            while (k < 8)
+                indices[mask][k++] = 0;
+        }
+    }
+};
+
+inline const CompactTable &compactTable() {
+    static const CompactTable table;
+    return table;
+}
+
+__attribute__((target("avx2")))
+inline size_t filterUnvisitedAVX2(const int *ids, size_t count, const uint32_t *bits, int *out) {
+    const CompactTable &table = compactTable();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i low5 = _mm256_set1_epi32(31);
+    size_t k = 0, i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(ids + i));
+        __m256i words = _mm256_i32gather_epi32((const int *)bits, _mm256_srli_epi32(v, 5), 4);
+        __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(v, low5)), one);
+        int visited = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(bit, one)));
+        int keep = ~visited & 0xFF;
+
+        __m256i perm = _mm256_load_si256((const __m256i *)table.indices[keep]);
+        _mm256_storeu_si256((__m256i *)(out + k), _mm256_permutevar8x32_epi32(v, perm));
+        k += __builtin_popcount(keep);
+    }
+    return k + filterUnvisitedScalar(ids + i, count - i, bits, out + k);
+}
+
+__attribute__((target("avx2")))
+inline size_t filterUnvisitedBytesAVX2(const int *ids, size_t count, const char *flags, int *out) {
+    const CompactTable &table = compactTable();
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i lowByte = _mm256_set1_epi32(0xFF);
+    size_t k = 0, i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(ids + i));
+        __m256i words = _mm256_i32gather_epi32((const int *)flags, _mm256_srli_epi32(v, 2), 4);
+        __m256i shift = _mm256_slli_epi32(_mm256_and_si256(v, three), 3);
+        __m256i flag = _mm256_and_si256(_mm256_srlv_epi32(words, shift), lowByte);
+        int keep = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(flag, _mm256_setzero_si256())));
+
+        __m256i perm = _mm256_load_si256((const __m256i *)table.indices[keep]);
+        _mm256_storeu_si256((__m256i *)(out + k), _mm256_permutevar8x32_epi32(v, perm));
+        k += __builtin_popcount(keep);
+    }
+    return k + filterUnvisitedBytesScalar(ids + i, count - i, flags, out + k);
+}
+
+__attribute__((target("avx2")))
+inline size_t filterUnstampedAVX2(const int *ids, size_t count, const uint32_t *stamp, uint32_t epoch, int *out) {
+    const CompactTable &table = compactTable();
+    const __m256i visitedStamp = _mm256_set1_epi32(epoch);
+    size_t k = 0, i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(ids + i));
+        __m256i stamps = _mm256_i32gather_epi32((const int *)stamp, v, 4);
+        int visited = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(stamps, visitedStamp)));
+        int keep = ~visited & 0xFF;
+
+        __m256i perm = _mm256_load_si256((const __m256i *)table.indices[keep]);
+        _mm256_storeu_si256((__m256i *)(out + k), _mm256_permutevar8x32_epi32(v, perm));
+        k += __builtin_popcount(keep);
+    }
+    return k + filterUnstampedScalar(ids + i, count - i, stamp, epoch, out + k);
+}
+
+__attribute__((target("avx512f")))
+inline size_t filterUnvisitedAVX512(const int *ids, size_t count, const uint32_t *bits, int *out) {
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i low5 = _mm512_set1_epi32(31);
+    size_t k = 0, i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512i v = _mm512_loadu_si512((const void *)(ids + i));
+        __m512i words = _mm512_i32gather_epi32(_mm512_srli_epi32(v, 5), (const void *)bits, 4);
+        __m512i bit = _mm512_srlv_epi32(words, _mm512_and_si512(v, low5));
+        __mmask16 keep = _mm512_testn_epi32_mask(bit, one);
+
+        _mm512_mask_compressstoreu_epi32(out + k, keep, v);
+        k += __builtin_popcount(keep);
+    }
+    return k + filterUnvisitedScalar(ids + i, count - i, bits, out + k);
+}
+
+__attribute__((target("avx512f")))
+inline size_t filterUnvisitedBytesAVX512(const int *ids, size_t count, const char *flags, int *out) {
+    const __m512i three = _mm512_set1_epi32(3);
+    const __m512i lowByte = _mm512_set1_epi32(0xFF);
+    size_t k = 0, i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512i v = _mm512_loadu_si512((const void *)(ids + i));
+        __m512i words = _mm512_i32gather_epi32(_mm512_srli_epi32(v, 2), (const void *)flags, 4);
+        __m512i shift = _mm512_slli_epi32(_mm512_and_si512(v, three), 3);
+        __mmask16 keep = _mm512_testn_epi32_mask(_mm512_srlv_epi32(words, shift), lowByte);
+
+        _mm512_mask_compressstoreu_epi32(out + k, keep, v);
+        k += __builtin_popcount(keep);
+    }
+    return k + filterUnvisitedBytesScalar(ids + i, count - i, flags, out + k);
+}
+
+__attribute__((target("avx512f")))
+inline size_t filterUnstampedAVX512(const int *ids, size_t count, const uint32_t *stamp, uint32_t epoch, int *out) {
+    const __m512i visitedStamp = _mm512_set1_epi32(epoch);
+    size_t k = 0, i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512i v = _mm512_loadu_si512((const void *)(ids + i));
+        __m512i stamps = _mm512_i32gather_epi32(v, (const void *)stamp, 4);
+        __mmask16 keep = _mm512_cmpneq_epi32_mask(stamps, visitedStamp);
+
+        _mm512_mask_compressstoreu_epi32(out + k, keep, v);
+        k += __builtin_popcount(keep);
+    }
+    return k + filterUnstampedScalar(ids + i, count - i, stamp, epoch, out + k);
+}
+
+#endif
+
+enum class FilterKernel { Scalar, AVX2, AVX512 };
+
+inline const char *filterKernelName(FilterKernel kernel) {
+    switch (kernel)
+    {
+    case FilterKernel::Scalar: return "scalar";
+    case FilterKernel::AVX2: return "avx2";
+    case FilterKernel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+inline bool filterKernelSupported(FilterKernel kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (kernel)
+    {
+    case FilterKernel::Scalar: return true;
+    case FilterKernel::AVX2: return __builtin_cpu_supports("avx2");
+    case FilterKernel::AVX512: return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return kernel == FilterKernel::Scalar;
+#endif
+}
+
+// Widest kernel the running CPU supports.
+inline FilterKernel bestFilterKernel() {
+    if (filterKernelSupported(FilterKernel::AVX512))
+        return FilterKernel::AVX512;
+    if (filterKernelSupported(FilterKernel::AVX2))
+        return FilterKernel::AVX2;
+    return FilterKernel::Scalar;
+}
+
+// kernel if the running CPU supports it, else the widest one it does.
+inline FilterKernel usableFilterKernel(FilterKernel kernel) {
+    return filterKernelSupported(kernel) ? kernel : bestFilterKernel();
+}
+
+inline NeighborFilter neighborFilter(FilterKernel kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (kernel == FilterKernel::AVX512 && filterKernelSupported(kernel))
+        return filterUnvisitedAVX512;
+    if (kernel == FilterKernel::AVX2 && filterKernelSupported(kernel))
+        return filterUnvisitedAVX2;
+#endif
+    return filterUnvisitedScalar;
+}
+
+// Writes the unvisited IDs among ids[0 .. count) to out, in order, and
+// returns how many there are. kernel must be usable on this CPU.
+inline size_t filterNeighbors(FilterKernel kernel, const VisitedView &visited, const int *ids, size_t count,
+                              int *out) {
+    switch (visited.layout)
+    {
+    case VisitedView::Bits:
+        return neighborFilter(kernel)(ids, count, (const uint32_t *)visited.data, out);
+    case VisitedView::Bytes:
+#if defined(__x86_64__) || defined(__i386__)
+        if (((uintptr_t)visited.data & 3) == 0)
+        {
+            if (kernel == FilterKernel::AVX512)
+                return filterUnvisitedBytesAVX512(ids, count, (const char *)visited.data, out);
+            if (kernel == FilterKernel::AVX2)
+                return filterUnvisitedBytesAVX2(ids, count, (const char *)visited.data, out);
+        }
+#endif
+        return filterUnvisitedBytesScalar(ids, count, (const char *)visited.data, out);
+    case VisitedView::Stamps:
+#if defined(__x86_64__) || defined(__i386__)
+        if (kernel == FilterKernel::AVX512)
+            return filterUnstampedAVX512(ids, count, (const uint32_t *)visited.data, visited.epoch, out);
+        if (kernel == FilterKernel::AVX2)
+            return filterUnstampedAVX2(ids, count, (const uint32_t *)visited.data, visited.epoch, out);
+#endif
+        return filterUnstampedScalar(ids, count, (const uint32_t *)visited.data, visited.epoch, out);
+    }
+    return 0;
+}
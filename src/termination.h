@@ -0,0 +1,147 @@
+#pragma once
+
+#include <mpi.h>
+
+// Distributed termination detection for asynchronous MPI traversals.
+//
+// Uses message counting (Mattern's four-counter method) over non-blocking
+// MPI_Iallreduce waves. Each rank counts the work messages it has sent and
+// received. Whenever it runs out of local work it contributes its counts to
+// the next wave and goes back to polling for messages; it never waits on the
+// reduction. The traversal is over once two consecutive waves report the
+// same totals with sent == received: nothing was in flight during the
+// first wave, and nobody became active again before the second.
+
+class TerminationDetector {
+public:
+    explicit TerminationDetector(MPI_Comm comm) : comm(comm) {}
+
+    TerminationDetector(const TerminationDetector &) = delete;
+    TerminationDetector &operator=(const TerminationDetector &) = delete;
+
+    void messageSent(long long count = 1) { sent += count; }
+    void messageReceived(long long count = 1) { received += count; }
+
+    // Call regularly from the traversal loop with passive = true when the rank
+    // has no local work and no unsent buffers. Starts a wave when passive and
+    // none is running, progresses the current one otherwise. Returns true once
+    // global termination is established; every rank sees it in the same wave.
+    bool poll(bool passive) {
+        if (terminated)
+            return true;
+
+        if (waveInFlight)
+        {
+            int done = 0;
+            MPI_Test(&wave, &done, MPI_STATUS_IGNORE);
+            if (!done)
+                return false;
+
+            waveInFlight = false;
+            numWaves++;
+            onWaveComplete();
+            if (terminated)
+                return true;
+        }
+
+        if (passive)
+        {
+            snapshot[0] = sent;
+            snapshot[1] = received;
+            MPI_Iallreduce(snapshot, totals, 2, MPI_LONG_LONG, MPI_SUM, comm, &wave);
+            waveInFlight = true;
+        }
+        return false;
+    }
+
+    long long wavesCompleted() const { return numWaves; }
+    long long messagesSent() const { return sent; }
+
+private:
+    void onWaveComplete() {
+        bool quiet = totals[0] == totals[1];
+        terminated = quiet && havePrevious && totals[0] == previous[0] && totals[1] == previous[1];
+        previous[0] = totals[0];
+        previous[1] = totals[1];
+        havePrevious = quiet;
+    }
+
+    MPI_Comm comm;
+    MPI_Request wave = MPI_REQUEST_NULL;
+    bool waveInFlight = false;
+    bool terminated = false;
+    bool havePrevious = false;
+    long long sent = 0;
+    long long received = 0;
+    long long snapshot[2] = {0, 0};
+    long long totals[2] = {0, 0};
+    long long previous[2] = {0, 0};
+    long long numWaves = 0;
+};
+
+// Cross-rank stop flag for early termination, e.g. once any rank has found
+// the search target. Each rank exposes one int in an RMA window held open
+// with MPI_Win_lock_all for the signal's lifetime. raise() writes 1 into
+// every rank's flag with MPI_Accumulate; raised() reads the local flag with
+// MPI_Fetch_and_op, so polling is a local atomic and never waits on other
+// ranks. Construction, reset() and destruction are collective.
+class StopSignal {
+public:
+    explicit StopSignal(MPI_Comm comm) : comm(comm) {
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &numRanks);
+        MPI_Win_allocate(sizeof(int), sizeof(int), MPI_INFO_NULL, comm, &flag, &win);
+        *flag = 0;
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+        MPI_Barrier(comm);
+    }
+
+    ~StopSignal() {
+        MPI_Win_unlock_all(win);
+        MPI_Win_free(&win);
+    }
+
+    StopSignal(const StopSignal &) = delete;
+    StopSignal &operator=(const StopSignal &) = delete;
+
+    // Clears the flag everywhere before a new traversal. The first barrier
+    // makes sure no raise() from the previous traversal is still landing.
+    void reset() {
+        MPI_Barrier(comm);
+        int zero = 0, old;
+        MPI_Fetch_and_op(&zero, &old, MPI_INT, rank, 0, MPI_REPLACE, win);
+        MPI_Win_flush(rank, win);
+        raisedHere = false;
+        MPI_Barrier(comm);
+    }
+
+    // Sets the flag on every rank; completes before returning.
+    void raise() {
+        if (raisedHere)
+            return;
+        raisedHere = true;
+
+        int one = 1;
+        for (int r = 0; r < numRanks; r++)
+            MPI_Accumulate(&one, 1, MPI_INT, r, 0, 1, MPI_INT, MPI_REPLACE, win);
+        MPI_Win_flush_all(win);
+    }
+
+    bool raised() {
+        if (raisedHere)
+            return true;
+
+        int unused = 0, value;
+        MPI_Fetch_and_op(&unused, &value, MPI_INT, rank, 0, MPI_NO_OP, win);
+        MPI_Win_flush(rank, win);
+        return value != 0;
+    }
+
+private:
+    MPI_Comm comm;
+    MPI_Win win;
+    int *flag = nullptr;
+    int rank = 0;
+    int numRanks = 1;
+    bool raisedHere = false;
+};
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <omp.h>
+
+// Topological sort with cycle detection.
+//
+// topoSortSerial uses DFS finish order (reverse postorder). topoSortParallel
+// uses level-synchronous Kahn: every vertex whose in-degree drops to zero in
+// one level forms the next frontier, which is processed with a parallel for.
+// Both report one witness cycle when the graph is not a DAG.
+//
+// Forking threads costs more than a narrow level is worth, so levels below
+// parallelThreshold vertices run serially. The parallel version only pays
+// off on wide DAGs, whose levels hold many thousands of vertices; on long
+// narrow ones it amounts to a serial Kahn.
+
+struct TopoResult {
+    std::vector<int> order;   // topological order, empty when hasCycle
+    bool hasCycle = false;
+    std::vector<int> cycle;   // witness cycle v0 -> v1 -> ... -> v0 (v0 not repeated)
+};
+
+// A back edge to i closes a cycle made of the DFS stack from i to the top.
+inline std::vector<int> cycleFromStack(const std::vector<std::pair<int, int>> &stack, int i) {
+    size_t pos = stack.size();
+    while (stack[pos - 1].first != i)
+        pos--;
+
+    std::vector<int> cycle;
+    for (size_t k = pos - 1; k < stack.size(); k++)
+        cycle.push_back(stack[k].first);
+    return cycle;
+}
+
+// Finds one cycle among vertices with inSubgraph[v] set (all vertices when
+// inSubgraph is empty). Iterative so that long chains do not overflow the stack.
+inline std::vector<int> findCycle(const std::vector<std::vector<int>> &adj,
+                                  const std::vector<char> &inSubgraph = std::vector<char>()) {
+    int n = adj.size();
+    std::vector<char> color(n, 0); // 0 = unvisited, 1 = on stack, 2 = finished
+    std::vector<std::pair<int, int>> stack; // (vertex, next neighbor index)
+
+    for (int root = 0; root < n; root++)
+    {
+        if (color[root] != 0 || (!inSubgraph.empty() && !inSubgraph[root]))
+            continue;
+
+        color[root] = 1;
+        stack.push_back({root, 0});
+
+        while (!stack.empty())
+        {
+            int s = stack.back().first;
+            int &idx = stack.back().second;
+
+            if (idx < (int)adj[s].size())
+            {
+                int i = adj[s][idx++];
+                if (!inSubgraph.empty() && !inSubgraph[i])
+                    continue;
+
+                if (color[i] == 0)
+                {
+                    color[i] = 1;
+                    stack.push_back({i, 0});
+                }
+                else if (color[i] == 1)
+                {
+                    return cycleFromStack(stack, i);
+                }
+            }
+            else
+            {
+                color[s] = 2;
+                stack.pop_back();
+            }
+        }
+    }
+    return std::vector<int>();
+}
+
+// Serial topological sort from DFS postorder
+inline TopoResult topoSortSerial(const std::vector<std::vector<int>> &adj) {
+    int n = adj.size();
+    TopoResult result;
+    std::vector<char> color(n, 0);
+    std::vector<std::pair<int, int>> stack;
+    result.order.reserve(n);
+
+    for (int root = 0; root < n; root++)
+    {
+        if (color[root] != 0)
+            continue;
+
+        color[root] = 1;
+        stack.push_back({root, 0});
+
+        while (!stack.empty())
+        {
+            int s = stack.back().first;
+            int &idx = stack.back().second;
+
+            if (idx < (int)adj[s].size())
+            {
+                int i = adj[s][idx++];
+                if (color[i] == 0)
+                {
+                    color[i] = 1;
+                    stack.push_back({i, 0});
+                }
+                else if (color[i] == 1)
+                {
+                    result.cycle = cycleFromStack(stack, i);
+                    result.hasCycle = true;
+                    result.order.clear();
+                    return result;
+                }
+            }
+            else
+            {
+                color[s] = 2;
+                result.order.push_back(s);
+                stack.pop_back();
+            }
+        }
+    }
+
+    std::reverse(result.order.begin(), result.order.end());
+    return result;
+}
+
+// Parallel topological sort (level-synchronous Kahn)
+inline TopoResult topoSortParallel(const std::vector<std::vector<int>> &adj, int parallelThreshold = 4096) {
+    int n = adj.size();
+    TopoResult result;
+    std::vector<int> inDegree(n, 0);
+
+    #pragma omp parallel for schedule(dynamic, 1024) if (n >= parallelThreshold)
+    for (int s = 0; s < n; s++)
+    {
+        for (int i : adj[s])
+        {
+            #pragma omp atomic
+            inDegree[i]++;
+        }
+    }
+
+    result.order.resize(n);
+    int frontierBegin = 0;
+    int frontierEnd = 0;
+
+    // Seed the first level; the order array doubles as the frontier queue.
+    for (int s = 0; s < n; s++)
+    {
+        if (inDegree[s] == 0)
+            result.order[frontierEnd++] = s;
+    }
+
+    int numThreads = omp_get_max_threads();
+    std::vector<std::vector<int>> nextLocal(numThreads);
+    std::vector<int> offsets(numThreads + 1, 0);
+
+    while (frontierBegin < frontierEnd)
+    {
+        if (numThreads == 1 || frontierEnd - frontierBegin < parallelThreshold)
+        {
+            int levelEnd = frontierEnd;
+            for (int k = frontierBegin; k < levelEnd; k++)
+            {
+                for (int i : adj[result.order[k]])
+                {
+                    if (--inDegree[i] == 0)
+                        result.order[frontierEnd++] = i;
+                }
+            }
+            frontierBegin = levelEnd;
+            continue;
+        }
+
+        for (std::vector<int> &next : nextLocal)
+            next.clear();
+
+        #pragma omp parallel num_threads(numThreads)
+        {
+            int tid = omp_get_thread_num();
+            std::vector<int> &next = nextLocal[tid];
+
+            #pragma omp for schedule(dynamic, 256)
+            for (int k = frontierBegin; k < frontierEnd; k++)
+            {
+                int s = result.order[k];
+                for (int i : adj[s])
+                {
+                    int remaining;
+                    #pragma omp atomic capture
+                    remaining = --inDegree[i];
+
+                    if (remaining == 0)
+                        next.push_back(i);
+                }
+            }
+
+            #pragma omp single
+            {
+                offsets[0] = frontierEnd;
+                for (int t = 0; t < numThreads; t++)
+                    offsets[t + 1] = offsets[t] + nextLocal[t].size();
+            }
+
+            std::copy(next.begin(), next.end(), result.order.begin() + offsets[tid]);
+        }
+
+        frontierBegin = frontierEnd;
+        frontierEnd = offsets[numThreads];
+    }
+
+    if (frontierEnd < n)
+    {
+        // Vertices never released all sit on or behind a cycle; every one of
+        // them keeps a predecessor inside the leftover subgraph.
+        std::vector<char> leftover(n, 0);
+        for (int s = 0; s < n; s++)
+            leftover[s] = inDegree[s] > 0;
+
+        result.hasCycle = true;
+        result.cycle = findCycle(adj, leftover);
+        result.order.clear();
+    }
+    return result;
+}
+
+// Checks that order is a permutation of all vertices respecting every edge
+inline bool isTopologicalOrder(const std::vector<std::vector<int>> &adj, const std::vector<int> &order) {
+    int n = adj.size();
+    if ((int)order.size() != n)
+        return false;
+
+    std::vector<int> position(n, -1);
+    for (int k = 0; k < n; k++)
+    {
+        if (order[k] < 0 || order[k] >= n || position[order[k]] != -1)
+            return false;
+        position[order[k]] = k;
+    }
+
+    for (int s = 0; s < n; s++)
+        for (int i : adj[s])
+            if (position[s] >= position[i])
+                return false;
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// Reusable scratch state for repeated traversals of the same graph.
+//
+// visited is an array of epoch stamps: vertex v counts as visited when
+// stamp[v] equals the current epoch, so begin() forgets all previous marks
+// by bumping the epoch instead of clearing n entries. The stamps are only
+// cleared when the 32-bit epoch wraps around. The stack and result buffers
+// keep their capacity between traversals, so a small query costs time in
+// proportion to what it reaches, not to the size of the graph.
+
+class TraversalContext {
+public:
+    explicit TraversalContext(int numVertices = 0) : stamp(numVertices, 0) {}
+
+    // Starts a new traversal over a graph with numVertices vertices.
+    void begin(int numVertices) {
+        if ((int)stamp.size() < numVertices)
+            stamp.resize(numVertices, 0);
+        if (++epoch == 0)
+        {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            epoch = 1;
+        }
+        res.clear();
+        stack.clear();
+    }
+
+    bool isVisited(int v) const { return stamp[v] == epoch; }
+
+    // Marks v visited; false if it already was in this traversal.
+    bool markVisited(int v) {
+        if (stamp[v] == epoch)
+            return false;
+        stamp[v] = epoch;
+        return true;
+    }
+
+    // Thread-safe markVisited for parallel engines.
+    bool claimVisited(int v) {
+        uint32_t old;
+        #pragma omp atomic capture
+        {
+            old = stamp[v];
+            stamp[v] = epoch;
+        }
+        return old != epoch;
+    }
+
+    // Raw stamps for the SIMD neighbor filter: v is visited when
+    // stamps()[v] == currentEpoch().
+    const uint32_t *stamps() const { return stamp.data(); }
+    uint32_t currentEpoch() const { return epoch; }
+
+    std::vector<int> &result() { return res; }
+    std::vector<int> &scratchStack() { return stack; }
+    size_t capacity() const { return stamp.size(); }
+
+private:
+    std::vector<uint32_t> stamp;
+    uint32_t epoch = 0;
+    std::vector<int> res;
+    std::vector<int> stack;
+};
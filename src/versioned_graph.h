@@ -0,0 +1,406 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <sched.h>
+#include "csr_graph.h"
+#include "dfs_engine.h"
+#include "incremental_dfs.h"
+
+// Versioned graph store: traversals read a consistent snapshot while a
+// writer applies edge batches.
+//
+// A version is an immutable base CSR plus the delta segments written since
+// it. A segment holds the complete new neighbor list of every vertex its
+// batch touched, so a vertex's list is always contiguous: the newest
+// segment that has it, else the base. Each version keeps a sorted overlay
+// index of those lists, and a lookup is one binary search (none when the
+// overlay is empty).
+//
+// Readers pin a version without locks or reference counts: snapshot()
+// announces the current epoch in a reader slot and then loads the current
+// version. The writer publishes a new version, retires the old one with the
+// epoch it advanced from, and frees it once every announced epoch is later.
+// Bases and segments are shared between versions through shared_ptr and go
+// away with the last version that uses them.
+//
+// As segments pile up, a background thread compacts: it copies a pinned
+// version into a new base CSR and publishes it together with any segments
+// that arrived while it was copying. Compactions run one at a time, so the
+// version a compaction started from is always built on the current base.
+
+// One batch's replacement neighbor lists, for the vertices it touched.
+struct GraphDelta {
+    uint64_t version = 0;       // version the batch produced
+    std::vector<int> vertices;  // sorted
+    std::vector<int64_t> offsets;
+    std::vector<int> neighbors;
+};
+
+struct GraphVersion {
+    struct OverlayEntry {
+        int vertex;
+        const int *begin;
+        const int *end;
+    };
+
+    uint64_t number = 0;
+    std::shared_ptr<const CSRGraph> base;
+    std::vector<std::shared_ptr<const GraphDelta>> deltas; // since base, oldest first
+    std::vector<OverlayEntry> overlay;                     // sorted by vertex, newest list
+    int64_t overlayEdges = 0;
+
+    int size() const { return base->size(); }
+
+    void neighbors(int v, const int *&first, const int *&last) const {
+        if (!overlay.empty())
+        {
+            auto it = std::lower_bound(overlay.begin(), overlay.end(), v,
+                                       [](const OverlayEntry &e, int vertex) { return e.vertex < vertex; });
+            if (it != overlay.end() && it->vertex == v)
+            {
+                first = it->begin;
+                last = it->end;
+                return;
+            }
+        }
+        first = base->begin(v);
+        last = base->end(v);
+    }
+
+    // Appends a delta; its lists replace any older ones in the overlay.
+    void addDelta(const std::shared_ptr<const GraphDelta> &delta) {
+        deltas.push_back(delta);
+        std::vector<OverlayEntry> merged;
+        merged.reserve(overlay.size() + delta->vertices.size());
+        overlayEdges = 0;
+        size_t i = 0;
+        for (size_t k = 0; k < delta->vertices.size(); k++)
+        {
+            int v = delta->vertices[k];
+            while (i < overlay.size() && overlay[i].vertex < v)
+                merged.push_back(overlay[i++]);
+            if (i < overlay.size() && overlay[i].vertex == v)
+                i++;
+            const int *lists = delta->neighbors.data();
+            merged.push_back({v, lists + delta->offsets[k], lists + delta->offsets[k + 1]});
+        }
+        merged.insert(merged.end(), overlay.begin() + i, overlay.end());
+        for (const OverlayEntry &e : merged)
+            overlayEdges += e.end - e.begin;
+        overlay.swap(merged);
+    }
+};
+
+class VersionedGraph;
+
+// A pinned version; the graph interface the engines expect. Movable, and
+// unpins on destruction.
+class GraphSnapshot {
+public:
+    GraphSnapshot() = default;
+    GraphSnapshot(GraphSnapshot &&other) noexcept
+        : slot(std::exchange(other.slot, nullptr)), current(std::exchange(other.current, nullptr)) {}
+    GraphSnapshot &operator=(GraphSnapshot &&other) noexcept {
+        if (this != &other)
+        {
+            release();
+            slot = std::exchange(other.slot, nullptr);
+            current = std::exchange(other.current, nullptr);
+        }
+        return *this;
+    }
+    GraphSnapshot(const GraphSnapshot &) = delete;
+    GraphSnapshot &operator=(const GraphSnapshot &) = delete;
+    ~GraphSnapshot() { release(); }
+
+    uint64_t version() const { return current->number; }
+    int size() const { return current->size(); }
+    void neighbors(int v, const int *&first, const int *&last) const { current->neighbors(v, first, last); }
+    int degree(int v) const {
+        const int *first, *last;
+        neighbors(v, first, last);
+        return last - first;
+    }
+
+private:
+    friend class VersionedGraph;
+
+    GraphSnapshot(std::atomic<uint64_t> *slot, const GraphVersion *current) : slot(slot), current(current) {}
+
+    void release() {
+        if (slot)
+            slot->store(0);
+        slot = nullptr;
+        current = nullptr;
+    }
+
+    std::atomic<uint64_t> *slot = nullptr;
+    const GraphVersion *current = nullptr;
+};
+
+template <>
+struct GraphTraits<GraphSnapshot> {
+    static const bool contiguous = true;
+
+    static int numVertices(const GraphSnapshot &g) { return g.size(); }
+
+    template <typename F>
+    static void forEachNeighbor(const GraphSnapshot &g, int v, F f) {
+        const int *first, *last;
+        g.neighbors(v, first, last);
+        for (const int *it = first; it != last; ++it)
+            f(*it);
+    }
+
+    static const int *neighborsBegin(const GraphSnapshot &g, int v) {
+        const int *first, *last;
+        g.neighbors(v, first, last);
+        return first;
+    }
+    static const int *neighborsEnd(const GraphSnapshot &g, int v) {
+        const int *first, *last;
+        g.neighbors(v, first, last);
+        return last;
+    }
+    static void prefetchIndex(const GraphSnapshot &, int) {}
+};
+
+struct VersionedGraphStats {
+    long long versionsPublished = 0;
+    long long versionsFreed = 0;
+    long long compactions = 0;
+};
+
+class VersionedGraph {
+public:
+    // Compaction starts once the overlay lists hold more edges than
+    // compactRatio times the base's edge count, or once there are maxDeltas
+    // segments; a compactRatio of 0 disables the background thread.
+    explicit VersionedGraph(const std::vector<std::vector<int>> &adj, double compactRatio = 0.05,
+                            int maxDeltas = 64, int maxReaders = 256)
+        : slots(maxReaders), compactRatio(compactRatio), maxDeltas(maxDeltas) {
+        for (std::atomic<uint64_t> &slot : slots)
+            slot.store(0);
+        GraphVersion *first = new GraphVersion();
+        first->base = std::make_shared<const CSRGraph>(adj);
+        current.store(first);
+        if (compactRatio > 0)
+            compactor = std::thread(&VersionedGraph::compactLoop, this);
+    }
+
+    VersionedGraph(const VersionedGraph &) = delete;
+    VersionedGraph &operator=(const VersionedGraph &) = delete;
+
+    // All snapshots must be released first.
+    ~VersionedGraph() {
+        {
+            std::lock_guard<std::mutex> lock(writeMutex);
+            stopping = true;
+        }
+        compactWanted.notify_all();
+        if (compactor.joinable())
+            compactor.join();
+        for (const std::pair<uint64_t, const GraphVersion *> &r : retired)
+            delete r.second;
+        delete current.load();
+    }
+
+    // Pins the current version. Waits if every reader slot is taken.
+    GraphSnapshot snapshot() {
+        while (true)
+        {
+            for (std::atomic<uint64_t> &slot : slots)
+            {
+                uint64_t idle = 0;
+                if (slot.load(std::memory_order_relaxed) == 0 && slot.compare_exchange_strong(idle, epoch.load()))
+                    return GraphSnapshot(&slot, current.load());
+            }
+            sched_yield();
+        }
+    }
+
+    // Applies deletions, then insertions, as one new version. Deleting an
+    // absent edge is ignored; with parallel edges one copy is removed.
+    uint64_t applyBatch(const EdgeBatch &batch) {
+        std::unique_lock<std::mutex> lock(writeMutex);
+        const GraphVersion *old = current.load();
+
+        std::vector<std::pair<int, int>> changes; // (source, index into batch), deletions first
+        int numDeletions = batch.deletions.size();
+        for (int i = 0; i < numDeletions; i++)
+            changes.push_back({batch.deletions[i].first, i});
+        for (int i = 0; i < (int)batch.insertions.size(); i++)
+            changes.push_back({batch.insertions[i].first, numDeletions + i});
+        std::stable_sort(changes.begin(), changes.end(),
+                         [](const std::pair<int, int> &a, const std::pair<int, int> &b) { return a.first < b.first; });
+
+        std::shared_ptr<GraphDelta> delta = std::make_shared<GraphDelta>();
+        delta->version = old->number + 1;
+        delta->offsets.push_back(0);
+        std::vector<int> list;
+        for (size_t i = 0; i < changes.size();)
+        {
+            int v = changes[i].first;
+            const int *first, *last;
+            old->neighbors(v, first, last);
+            list.assign(first, last);
+            for (; i < changes.size() && changes[i].first == v; i++)
+            {
+                int k = changes[i].second;
+                if (k < numDeletions)
+                {
+                    auto it = std::find(list.begin(), list.end(), batch.deletions[k].second);
+                    if (it != list.end())
+                        list.erase(it);
+                }
+                else
+                {
+                    list.push_back(batch.insertions[k - numDeletions].second);
+                }
+            }
+            delta->vertices.push_back(v);
+            delta->neighbors.insert(delta->neighbors.end(), list.begin(), list.end());
+            delta->offsets.push_back(delta->neighbors.size());
+        }
+
+        GraphVersion *next = new GraphVersion();
+        next->number = delta->version;
+        next->base = old->base;
+        next->deltas = old->deltas;
+        next->overlay = old->overlay;
+        next->addDelta(delta);
+        publish(next);
+
+        if (compactor.joinable() && needsCompaction(*next))
+        {
+            compactRequested = true;
+            compactWanted.notify_one();
+        }
+        return next->number;
+    }
+
+    // Folds all segments into a new base on the calling thread.
+    void compactNow() { compact(); }
+
+    uint64_t version() const { return current.load()->number; }
+    size_t pendingDeltas() const { return current.load()->deltas.size(); }
+
+    VersionedGraphStats stats() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        return statistics;
+    }
+
+private:
+    bool needsCompaction(const GraphVersion &v) const {
+        return (int)v.deltas.size() >= maxDeltas || v.overlayEdges > compactRatio * v.base->numEdges();
+    }
+
+    // Swaps in next and retires the old version; writeMutex must be held.
+    void publish(GraphVersion *next) {
+        const GraphVersion *old = current.exchange(next);
+        retired.push_back({epoch.fetch_add(1), old});
+        statistics.versionsPublished++;
+        reclaim();
+    }
+
+    // Frees retired versions no pinned reader can still see.
+    void reclaim() {
+        uint64_t oldestPinned = UINT64_MAX;
+        for (const std::atomic<uint64_t> &slot : slots)
+        {
+            uint64_t e = slot.load();
+            if (e != 0)
+                oldestPinned = std::min(oldestPinned, e);
+        }
+        size_t kept = 0;
+        for (const std::pair<uint64_t, const GraphVersion *> &r : retired)
+        {
+            if (r.first < oldestPinned)
+            {
+                delete r.second;
+                statistics.versionsFreed++;
+            }
+            else
+            {
+                retired[kept++] = r;
+            }
+        }
+        retired.resize(kept);
+    }
+
+    void compact() {
+        std::lock_guard<std::mutex> serial(compactMutex);
+        GraphSnapshot pinned = snapshot();
+        const GraphVersion *source = pinned.current;
+        if (source->deltas.empty())
+            return;
+
+        // The copy runs without the lock; writers keep publishing. assign
+        // visits vertices in order, so the overlay is walked, not searched.
+        std::shared_ptr<CSRGraph> base = std::make_shared<CSRGraph>();
+        const std::vector<GraphVersion::OverlayEntry> &overlay = source->overlay;
+        size_t cursor = 0;
+        base->assign(source->size(), [&](int v, auto emit) {
+            if (v == 0)
+                cursor = 0;
+            const int *first = source->base->begin(v), *last = source->base->end(v);
+            if (cursor < overlay.size() && overlay[cursor].vertex == v)
+            {
+                first = overlay[cursor].begin;
+                last = overlay[cursor].end;
+                cursor++;
+            }
+            for (const int *it = first; it != last; ++it)
+                emit(*it);
+        });
+
+        std::lock_guard<std::mutex> lock(writeMutex);
+        const GraphVersion *latest = current.load();
+        GraphVersion *next = new GraphVersion();
+        next->number = latest->number + 1;
+        next->base = base;
+        for (const std::shared_ptr<const GraphDelta> &delta : latest->deltas)
+            if (delta->version > source->number)
+                next->addDelta(delta);
+        publish(next);
+        statistics.compactions++;
+    }
+
+    void compactLoop() {
+        std::unique_lock<std::mutex> lock(writeMutex);
+        while (true)
+        {
+            compactWanted.wait(lock, [&] { return compactRequested || stopping; });
+            if (stopping)
+                return;
+            compactRequested = false;
+            lock.unlock();
+            compact();
+            lock.lock();
+        }
+    }
+
+    std::atomic<const GraphVersion *> current{nullptr};
+    std::atomic<uint64_t> epoch{1};
+    std::vector<std::atomic<uint64_t>> slots; // announced epoch per reader, 0 when free
+
+    std::mutex writeMutex;   // writers, publishing, retired list, statistics
+    std::mutex compactMutex; // one compaction at a time; taken before writeMutex
+    std::vector<std::pair<uint64_t, const GraphVersion *>> retired;
+    VersionedGraphStats statistics;
+
+    double compactRatio;
+    int maxDeltas;
+    std::thread compactor;
+    std::condition_variable compactWanted;
+    bool compactRequested = false;
+    bool stopping = false;
+};